@@ -1,5 +1,5 @@
 /*
-Simple hash-based dictionaries. Append-only, no deletion.
+Simple hash-based dictionaries. Deletion leaves tombstones; see `dict_del_at`.
 
 In this codebase:
 
@@ -7,19 +7,144 @@ In this codebase:
 - "map" = "hash table with opaque keys"
 
 See `./map.h`, `./map.c`.
+
+Unlike maps and sets, dicts don't probe one slot at a time. Slots are split
+into groups of `DICT_GROUP_LEN`, and each slot has a control byte: either
+`DICT_CTRL_EMPTY`, `DICT_CTRL_DELETED`, or the top 7 bits of the key's hash.
+A lookup compares
+a whole group of control bytes against the tag with a single vector compare,
+then checks the full hash and length in `Dict_meta`, and only then chases
+the key pointer. This is the layout popularized by Abseil's "Swiss tables".
+
+Word lookup in the interpreter is the main consumer; see `interp_word`.
+
+The `Hash_table` prefix (`bits`, `keys`, `vals`) is maintained as before,
+so `dict_range` and the Forth-side `.wordlist_log` keep working.
 */
 #pragma once
 #include "./dict.h" // IWYU pragma: export
+#include "./bits.c"
 #include "./hash_fnv.c"
 #include "./hash_table_common.c"
+#include "./mem.c"
 #include "./num.h"
 #include <string.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 // Used only for pointer arithmetic; ignored by hashing and equality.
 static constexpr U8 DICT_KEY_SIZE = sizeof(char *);
 
+// Control bytes are probed one group at a time; one 128-bit vector.
+static constexpr U8 DICT_GROUP_LEN = 16;
+
+// Also the minimum capacity; must be a multiple of `DICT_GROUP_LEN`.
+static constexpr U8 DICT_INIT_CAP = DICT_GROUP_LEN;
+
+// Tags only use the low 7 bits, so free slots never match a tag.
+static constexpr U8 DICT_CTRL_EMPTY   = 0b1000'0000;
+static constexpr U8 DICT_CTRL_DELETED = 0b1111'1110;
+
+/*
+Bits per slot in the masks returned by `dict_group_match`. SSE has a proper
+movemask; on NEON, the cheapest equivalent is a narrowing shift which leaves
+4 bits per byte. We keep only one of them, so popping works the same.
+*/
+#if defined(__aarch64__)
+static constexpr U8   DICT_MATCH_STRIDE = 4;
+static constexpr Bits DICT_MATCH_LANES  = 0x8888'8888'8888'8888;
+#else
+static constexpr U8 DICT_MATCH_STRIDE = 1;
+#endif
+
+static U8 dict_hash_tag(Fnv_hash hash) { return (U8)(hash >> 57); }
+
+static bool dict_ctrl_full(U8 ctrl) { return !(ctrl & DICT_CTRL_EMPTY); }
+
+#if defined(__aarch64__)
+static Bits dict_group_mask_neon(uint8x16_t src) {
+  const auto nib = vshrn_n_u16(vreinterpretq_u16_u8(src), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nib), 0) & DICT_MATCH_LANES;
+}
+#endif
+
+// Bitmask of the slots in the group whose control byte equals `byte`.
+static Bits dict_group_match(const U8 *ctrl, U8 byte) {
+#if defined(__aarch64__)
+  return dict_group_mask_neon(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(byte)));
+#elif defined(__x86_64__)
+  const auto src = _mm_loadu_si128((const __m128i *)ctrl);
+  const auto eq  = _mm_cmpeq_epi8(src, _mm_set1_epi8((char)byte));
+  return (Bits)(U16)_mm_movemask_epi8(eq);
+#else
+  Bits out = 0;
+  for (U8 ind = 0; ind < DICT_GROUP_LEN; ind++) {
+    if (ctrl[ind] == byte) out |= (Bits)1 << ind;
+  }
+  return out;
+#endif
+}
+
+// Bitmask of the slots in the group which are empty or deleted.
+static Bits dict_group_match_free(const U8 *ctrl) {
+#if defined(__aarch64__)
+  const auto src = vreinterpretq_s8_u8(vld1q_u8(ctrl));
+  return dict_group_mask_neon(vcltzq_s8(src));
+#elif defined(__x86_64__)
+  const auto src = _mm_loadu_si128((const __m128i *)ctrl);
+  return (Bits)(U16)_mm_movemask_epi8(src);
+#else
+  Bits out = 0;
+  for (U8 ind = 0; ind < DICT_GROUP_LEN; ind++) {
+    if (!dict_ctrl_full(ctrl[ind])) out |= (Bits)1 << ind;
+  }
+  return out;
+#endif
+}
+
+// Pops the lowest matching slot; the mask must be non-empty.
+static U8 dict_match_pop(Bits *match) {
+  return (U8)(bits_pop_low(match) / DICT_MATCH_STRIDE);
+}
+
+static Ind dict_group_mask(const Dict *dict) {
+  return dict->cap / DICT_GROUP_LEN - 1;
+}
+
+static void dict_init_impl(Dict *dict, Ind cap, Ind val_size) {
+  if (cap && cap < DICT_INIT_CAP) cap = DICT_INIT_CAP;
+
+  hash_table_init((Hash_table *)dict, cap, DICT_KEY_SIZE, val_size);
+  dict->ctrl  = nullptr;
+  dict->meta  = nullptr;
+  dict->tombs = 0;
+  if (!cap) return;
+
+  const auto ctrl = (U8 *)malloc(cap);
+  const auto meta = (Dict_meta *)memalloc(cap, sizeof(Dict_meta));
+  assert_fatal(ctrl);
+  assert_fatal(meta);
+  memset(ctrl, DICT_CTRL_EMPTY, cap);
+
+  dict->ctrl = ctrl;
+  dict->meta = meta;
+}
+
 // For dicts where keys are borrowed.
-static void dict_deinit(void *dict) { hash_table_deinit(dict); }
+static void dict_deinit(void *dict) {
+  const auto tar = (Dict *)dict;
+  if (!tar) return;
+  free(tar->ctrl);
+  free(tar->meta);
+  tar->ctrl  = nullptr;
+  tar->meta  = nullptr;
+  tar->tombs = 0;
+  hash_table_deinit(tar);
+}
 
 // For dicts where keys are owned.
 static void dict_deinit_with_keys(Dict *dict) {
@@ -28,56 +153,235 @@ static void dict_deinit_with_keys(Dict *dict) {
 }
 
 static bool dict_valid(const Dict *dict) {
-  return hash_table_valid((const Hash_table *)dict);
+  if (!hash_table_valid((const Hash_table *)dict)) return false;
+  if (!dict->cap) return !dict->ctrl && !dict->meta && !dict->tombs;
+  return dict->ctrl && dict->meta && !(dict->cap % DICT_GROUP_LEN) &&
+    dict->len + dict->tombs < dict->cap;
 }
 
 // For dicts where keys are borrowed.
-static void dict_trunc(Dict *dict) { hash_table_trunc((Hash_table *)dict); }
+static void dict_trunc(Dict *dict) {
+  hash_table_trunc((Hash_table *)dict);
+  if (dict->cap) memset(dict->ctrl, DICT_CTRL_EMPTY, dict->cap);
+  dict->tombs = 0;
+}
 
 // For dicts where keys are owned.
 static void dict_trunc_with_keys(Dict *dict) {
   for (dict_range(Ind, ind, dict)) free(dict->keys[ind]);
-  hash_table_trunc((Hash_table *)dict);
+  dict_trunc(dict);
+}
+
+/*
+Probes whole groups in triangular order, which visits every group exactly
+once when the group count is a power of 2. The first group with an empty
+slot terminates the search. Tombstones don't, since keys inserted before
+a deletion may have probed past them.
+*/
+static Ind dict_find(const Dict *dict, Dict_key key) {
+  if (!dict->cap) return INVALID_IND;
+
+  const auto tag  = dict_hash_tag(key.hash);
+  const auto mask = dict_group_mask(dict);
+  auto       grp  = (Ind)key.hash & mask;
+
+  for (Ind iter = 0; iter <= mask; iter++) {
+    const auto base  = grp * DICT_GROUP_LEN;
+    const auto ctrl  = dict->ctrl + base;
+    auto       match = dict_group_match(ctrl, tag);
+
+    while (match) {
+      const auto ind  = base + dict_match_pop(&match);
+      const auto meta = &dict->meta[ind];
+      if (meta->hash != key.hash || meta->len != key.len) continue;
+      if (memcmp(dict->keys[ind], key.buf, key.len)) continue;
+      return ind;
+    }
+
+    if (dict_group_match(ctrl, DICT_CTRL_EMPTY)) return INVALID_IND;
+    grp = (grp + iter + 1) & mask;
+  }
+  return INVALID_IND;
 }
 
-// Conforms to `Hash_fun`.
-static Fnv_hash dict_key_hash(const void *key, Ind len) {
-  (void)len;
-  return fnv_hash_str(*(const char *const *)key);
+/*
+Must have capacity. Finds the first empty or deleted slot along the probe
+sequence. The caller must have checked that the key is not present.
+*/
+static Ind dict_free_ind(const Dict *dict, Fnv_hash hash) {
+  assert_fatal(dict->cap > dict->len);
+
+  const auto mask = dict_group_mask(dict);
+  auto       grp  = (Ind)hash & mask;
+
+  for (Ind iter = 0; iter <= mask; iter++) {
+    const auto base  = grp * DICT_GROUP_LEN;
+    auto       match = dict_group_match_free(dict->ctrl + base);
+    if (match) return base + dict_match_pop(&match);
+    grp = (grp + iter + 1) & mask;
+  }
+  unreachable();
 }
 
-// Conforms to `Eq_fun`.
-static bool dict_key_eq(const void *one, const void *two, Ind len) {
-  (void)len;
-  return !strcmp(*(const char *const *)one, *(const char *const *)two);
+// The caller is responsible for the value.
+static void dict_occupy(
+  Dict *dict, Ind ind, char *key, Fnv_hash hash, Ind len
+) {
+  if (dict->ctrl[ind] == DICT_CTRL_DELETED) dict->tombs--;
+  dict->ctrl[ind] = dict_hash_tag(hash);
+  dict->meta[ind] = (Dict_meta){.hash = hash, .len = len};
+  dict->keys[ind] = key;
+  hash_table_bits_set_at(dict->bits, ind);
+  dict->len++;
+}
+
+/*
+Load factor 7/8, counting tombstones, since they lengthen probe sequences
+just like live entries. Group probing stays short even when fairly full.
+*/
+static bool dict_loaded(const Dict *dict) {
+  return (dict->len + dict->tombs + 1) * 8 > dict->cap * 7;
+}
+
+/*
+When the table is loaded mostly by tombstones, rehashing at the same
+capacity is enough to reclaim them. Otherwise we double the capacity.
+*/
+static Ind dict_grown_cap(const Dict *dict) {
+  return (dict->len + 1) * 16 <= dict->cap * 7 ? dict->cap : dict->cap * 2;
+}
+
+/*
+Reuses the stored hashes; keys are never rehashed.
+Tombstones are dropped; the new table has none.
+*/
+static void dict_rehash(Dict *prev, Ind cap, Ind val_size) {
+  Dict next;
+  dict_init_impl(&next, cap, val_size);
+
+  for (Ind ind_prev = 0; ind_prev < prev->cap; ind_prev++) {
+    if (!dict_ctrl_full(prev->ctrl[ind_prev])) continue;
+
+    const auto meta     = prev->meta[ind_prev];
+    const auto ind_next = dict_free_ind(&next, meta.hash);
+    dict_occupy(&next, ind_next, prev->keys[ind_prev], meta.hash, meta.len);
+
+    // Only non-zero-sized values are allocated or copied; see `Str_set`.
+    if (val_size) {
+      const auto val_prev = ptr_at(prev->vals, ind_prev, val_size);
+      const auto val_next = ptr_at(next.vals, ind_next, val_size);
+      memcpy(val_next, val_prev, val_size);
+    }
+  }
+
+  dict_deinit(prev);
+  *prev = next;
+}
+
+// Measures and hashes the string in one pass.
+static Dict_key dict_key(const char *buf) {
+  Dict_key out = {.buf = buf};
+  out.hash     = fnv_hash_str_len(buf, &out.len);
+  return out;
+}
+
+// For strings whose length is already known.
+static Dict_key dict_key_len(const char *buf, Ind len) {
+  return (Dict_key){
+    .buf  = buf,
+    .len  = len,
+    .hash = fnv_hash_bytes((const U8 *)buf, len),
+  };
 }
 
 static Ind dict_ind_impl(const Dict *dict, const char *key) {
-  return hash_table_matching_ind(
-    (const Hash_table *)dict,
-    (const void *)&key,
-    DICT_KEY_SIZE,
-    dict_key_hash,
-    dict_key_eq
-  );
+  if (!dict->cap) return INVALID_IND;
+  return dict_find(dict, dict_key(key));
 }
 
 static void *dict_set_impl(
   Dict *dict, const char *key, const void *val, Ind val_size
 ) {
-  return hash_table_set(
-    (Hash_table *)dict,
-    (const void *)&key,
-    val,
-    DICT_KEY_SIZE,
-    val_size,
-    dict_key_hash,
-    dict_key_eq
-  );
+  const auto tar = dict_key(key);
+  auto       ind = dict_find(dict, tar);
+
+  if (ind == INVALID_IND) {
+    if (!dict->cap) {
+      dict_init_impl(dict, DICT_INIT_CAP, val_size);
+    }
+    else if (dict_loaded(dict)) {
+      dict_rehash(dict, dict_grown_cap(dict), val_size);
+    }
+    ind = dict_free_ind(dict, tar.hash);
+    dict_occupy(dict, ind, (char *)key, tar.hash, tar.len);
+  }
+
+  // Only non-zero-sized values are allocated or copied; see `Str_set`.
+  if (!val_size) return nullptr;
+
+  const auto out = ptr_at(dict->vals, ind, val_size);
+  memcpy(out, val, val_size);
+  return out;
+}
+
+/*
+Doesn't touch the key or value; the caller is responsible for freeing an
+owned key beforehand.
+
+If the slot's group still has an empty slot, no probe sequence has ever
+continued past this group, so the slot can become empty again. Otherwise
+it becomes a tombstone, which is reclaimed either by a later insertion
+along the same probe sequence, or by the next rehash.
+*/
+static void dict_del_at(Dict *dict, Ind ind) {
+  IF_DEBUG(assert_fatal(ind < dict->cap));
+  IF_DEBUG(assert_fatal(dict_ctrl_full(dict->ctrl[ind])));
+
+  const auto base = ind - ind % DICT_GROUP_LEN;
+
+  if (dict_group_match(dict->ctrl + base, DICT_CTRL_EMPTY)) {
+    dict->ctrl[ind] = DICT_CTRL_EMPTY;
+  }
+  else {
+    dict->ctrl[ind] = DICT_CTRL_DELETED;
+    dict->tombs++;
+  }
+
+  hash_table_bits_del_at(dict->bits, ind);
+  dict->len--;
+}
+
+static bool dict_del_impl(Dict *dict, const char *key) {
+  const auto ind = dict_ind_impl(dict, key);
+  if (ind == INVALID_IND) return false;
+  dict_del_at(dict, ind);
+  return true;
 }
 
 static void dict_eprint_repr(const Dict *dict) {
-  hash_table_eprint_repr((const Hash_table *)dict);
+  eprintf(
+    "(Dict){\n"
+    "  .len  = " FMT_IND
+    ",\n"
+    "  .cap  = " FMT_IND
+    ",\n"
+    "  .bits = %p,\n"
+    "  .keys = %p,\n"
+    "  .vals = %p,\n"
+    "  .ctrl = %p,\n"
+    "  .meta = %p,\n"
+    "  .tombs = " FMT_IND
+    ",\n"
+    "}\n",
+    dict->len,
+    dict->cap,
+    dict->bits,
+    dict->keys,
+    dict->vals,
+    dict->ctrl,
+    dict->meta,
+    dict->tombs
+  );
 }
 
 /*
@@ -103,7 +407,7 @@ int main() {
   dict_set(&dict, "one", 10);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 1);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(!dict_has(&dict, ""));
   assert_fatal(dict_has(&dict, "one"));
   assert_fatal(dict_get(&dict, "one") == 10);
@@ -112,7 +416,7 @@ int main() {
   dict_set(&dict, "one", 20);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 1);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(!dict_has(&dict, ""));
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(!dict_has(&dict, "two"));
@@ -120,7 +424,7 @@ int main() {
   dict_set(&dict, "two", 30);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 2);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(!dict_has(&dict, ""));
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 30);
@@ -129,7 +433,7 @@ int main() {
   dict_set(&dict, "two", 40);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 2);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(!dict_has(&dict, ""));
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 40);
@@ -138,7 +442,7 @@ int main() {
   dict_set(&dict, "three", 50);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 3);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(!dict_has(&dict, ""));
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 40);
@@ -148,7 +452,7 @@ int main() {
   dict_set(&dict, "three", 60);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 3);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP * 2);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 40);
   assert_fatal(dict_get(&dict, "three") == 60);
@@ -156,7 +460,7 @@ int main() {
   dict_set(&dict, "four", 70);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 4);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP * 2);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 40);
   assert_fatal(dict_get(&dict, "three") == 60);
@@ -165,7 +469,7 @@ int main() {
   dict_set(&dict, "four", 80);
   // dict_eprint_repr((Dict *)&dict);
   assert_fatal(dict.len == 4);
-  assert_fatal(dict.cap == HASH_TABLE_INIT_CAP * 2);
+  assert_fatal(dict.cap == DICT_INIT_CAP);
 
   assert_fatal(dict_get(&dict, "one") == 20);
   assert_fatal(dict_get(&dict, "two") == 40);
@@ -178,11 +482,24 @@ int main() {
   assert_fatal(dict_get(&dict, strdup("three")) == 60);
   assert_fatal(dict_get(&dict, strdup("four")) == 80);
 
+  assert_fatal(dict_del(&dict, "two"));
+  assert_fatal(!dict_del(&dict, "two"));
+  assert_fatal(dict.len == 3);
+  assert_fatal(!dict_has(&dict, "two"));
+  assert_fatal(dict_get(&dict, "one") == 20);
+  assert_fatal(dict_get(&dict, "three") == 60);
+
+  dict_set(&dict, "two", 90);
+  assert_fatal(dict.len == 4);
+  assert_fatal(dict_get(&dict, "two") == 90);
+
   dict_deinit(&dict);
 
   assert_fatal(!dict.keys);
   assert_fatal(!dict.vals);
   assert_fatal(!dict.bits);
+  assert_fatal(!dict.ctrl);
+  assert_fatal(!dict.meta);
   assert_fatal(!dict.len);
   assert_fatal(!dict.cap);
 }
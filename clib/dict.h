@@ -1,11 +1,34 @@
 #pragma once
+#include "./hash_fnv.h"
 #include "./hash_table_common.h"
 #include "./num.h"
 #include <assert.h>
 #include <limits.h>
 
 /*
-Opaque dict header. Must be binary-compatible with `Hash_table`.
+Full hash and length of the key in the same slot; compared before
+chasing the key pointer. See `./dict.c`.
+*/
+typedef struct {
+  Fnv_hash hash;
+  Ind      len;
+} Dict_meta;
+
+/*
+Key with a precomputed hash and length; see `dict_key`. When the same
+string is looked up in several dicts, it only needs to be hashed once.
+The buffer is borrowed and must be null-terminated.
+*/
+typedef struct {
+  const char *buf;
+  Ind         len;
+  Fnv_hash    hash;
+} Dict_key;
+
+/*
+Opaque dict header. Starts with a prefix binary-compatible with `Hash_table`,
+which is enough for `dict_range` and for the Forth mirror to walk the keys.
+Lookups use the trailing fields instead; see `./dict.c`.
 
 The implementation makes no assumption if the keys are owned or borrowed.
 Consumer code decides this. See `dict_deinit` vs `dict_deinit_with_keys`.
@@ -13,20 +36,26 @@ Consumer code decides this. See `dict_deinit` vs `dict_deinit_with_keys`.
 SYNC[hash_table_structure].
 */
 typedef struct {
-  Ind    len;
-  Ind    cap;
-  Uint  *bits;
-  char **keys;
-  void  *vals;
+  Ind        len;
+  Ind        cap;
+  Uint      *bits;
+  char     **keys;
+  void      *vals;
+  U8        *ctrl;  // 7-bit hash tag per slot, or `DICT_CTRL_EMPTY/DELETED`.
+  Dict_meta *meta;
+  Ind        tombs; // Deleted slots not yet reclaimed; see `dict_del_at`.
 } Dict;
 
 #define dict_of(Elem) \
   struct {            \
-    Ind    len;       \
-    Ind    cap;       \
-    Uint  *bits;      \
-    char **keys;      \
-    Elem  *vals;      \
+    Ind        len;   \
+    Ind        cap;   \
+    Uint      *bits;  \
+    char     **keys;  \
+    Elem      *vals;  \
+    U8        *ctrl;  \
+    Dict_meta *meta;  \
+    Ind        tombs; \
   }
 
 typedef dict_of(Uint) Uint_dict;
@@ -52,26 +81,44 @@ typedef dict_of(Empty) Str_set;
 static constexpr auto  EMPTY = (Empty){};
 
 #define dict_init(dict, cap) \
-  hash_table_init((Hash_table *)dict, cap, DICT_KEY_SIZE, dict_val_size(dict));
+  dict_init_impl((Dict *)(dict), cap, dict_val_size(dict));
 
 // Returns `INVALID_IND` when key is not present.
 #define dict_ind(dict, key) dict_ind_impl((const Dict *)(dict), key)
 
 #define dict_has(dict, key) (dict_ind(dict, key) != INVALID_IND)
 
-#define dict_get_or_inner(tmp_dict, tmp_ind, dict, key, val)          \
-  ({                                                                  \
-    const auto tmp_dict = dict;                                       \
-    const auto tmp_ind  = dict_ind_impl((const Dict *)tmp_dict, key); \
-    (!dict_val_size(tmp_dict) || tmp_ind == INVALID_IND)              \
-      ? val                                                           \
-      : tmp_dict->vals[tmp_ind];                                      \
+// Same as `dict_ind`, but takes a `Dict_key`.
+#define dict_ind_key(dict, key) dict_find((const Dict *)(dict), key)
+
+/*
+Returns true if the key was present. Doesn't free the key;
+dicts which own their keys must free it beforehand.
+*/
+#define dict_del(dict, key) dict_del_impl((Dict *)(dict), key)
+
+#define dict_get_or_inner(tmp_dict, tmp_ind, find, dict, key, val) \
+  ({                                                              \
+    const auto tmp_dict = dict;                                   \
+    const auto tmp_ind  = find((const Dict *)tmp_dict, key);      \
+    (!dict_val_size(tmp_dict) || tmp_ind == INVALID_IND)          \
+      ? val                                                       \
+      : tmp_dict->vals[tmp_ind];                                  \
   })
 
-#define dict_get_or(...) dict_get_or_inner(UNIQ_IDENT, UNIQ_IDENT, __VA_ARGS__)
+#define dict_get_or(...) \
+  dict_get_or_inner(UNIQ_IDENT, UNIQ_IDENT, dict_ind_impl, __VA_ARGS__)
 
 #define dict_get(dict, key) dict_get_or(dict, key, (dict_val_type(dict)){0})
 
+// Same as `dict_get_or`, but takes a `Dict_key`.
+#define dict_get_key_or(...) \
+  dict_get_or_inner(UNIQ_IDENT, UNIQ_IDENT, dict_find, __VA_ARGS__)
+
+// Same as `dict_get`, but takes a `Dict_key`.
+#define dict_get_key(dict, key) \
+  dict_get_key_or(dict, key, (dict_val_type(dict)){0})
+
 /*
 Returned pointer is only valid until next dict resize.
 Doesn't copy the key; the caller is responsible for its lifetime.
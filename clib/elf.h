@@ -0,0 +1,221 @@
+/*
+Some of the data structures used in the ELF64 executable format.
+Only the subset needed for dynamically-linked executables is defined.
+
+Links:
+
+- https://refspecs.linuxfoundation.org/elf/gabi4+/contents.html
+- https://github.com/ARM-software/abi-aa/blob/main/aaelf64/aaelf64.rst
+- https://github.com/torvalds/linux/blob/master/include/uapi/linux/elf.h
+- https://github.com/torvalds/linux/blob/master/fs/binfmt_elf.c
+- https://sourceware.org/git/?p=glibc.git;a=blob;f=elf/elf.h
+- https://sourceware.org/git/?p=glibc.git;a=blob;f=elf/rtld.c
+- https://en.wikipedia.org/wiki/Executable_and_Linkable_Format
+
+Commands:
+
+  readelf --file-header --program-headers --dynamic --relocs --dyn-syms out.exe
+  llvm-objdump --disassemble-all --private-headers --dynamic-reloc out.exe
+  LD_DEBUG=all ./out.exe
+*/
+
+#pragma once
+#include "./misc.h"
+#include "./num.h"
+
+static constexpr U8 ELF_MAGIC[] = {0x7F, 'E', 'L', 'F'};
+
+// Values for `Elf_ident.class`.
+static constexpr U8 ELF_CLASS_64 = 2;
+
+// Values for `Elf_ident.data`.
+static constexpr U8 ELF_DATA_LSB = 1;
+
+// Values for `Elf_ident.version` and `Elf_head.e_version`.
+static constexpr U8 ELF_VER_CURRENT = 1;
+
+// Values for `Elf_ident.os_abi`.
+static constexpr U8 ELF_OSABI_SYSV = 0;
+
+// `e_ident` in `Elf64_Ehdr`.
+typedef struct {
+  U8 magic[4];
+  U8 class;
+  U8 data;
+  U8 version;
+  U8 os_abi;
+  U8 abi_ver;
+  U8 pad[7];
+} Elf_ident;
+
+static_assert(sizeof(Elf_ident) == 16);
+
+typedef enum : U16 {
+  EFT_NONE = 0,
+  EFT_REL  = 1,
+  EFT_EXEC = 2,
+  EFT_DYN  = 3,
+  EFT_CORE = 4,
+} Elf_file_type;
+
+typedef enum : U16 {
+  EMT_X64     = 62,
+  EMT_AARCH64 = 183,
+} Elf_machine;
+
+// `Elf64_Ehdr` in `<elf.h>`.
+typedef struct {
+  Elf_ident     e_ident;
+  Elf_file_type e_type;
+  Elf_machine   e_machine;
+  U32           e_version;
+  U64           e_entry;     // Virtual address of the entry point.
+  U64           e_phoff;     // File offset of the program header table.
+  U64           e_shoff;     // File offset of the section header table.
+  U32           e_flags;
+  U16           e_ehsize;    // sizeof(Elf_head)
+  U16           e_phentsize; // sizeof(Elf_prog_head)
+  U16           e_phnum;
+  U16           e_shentsize; // sizeof(Elf64_Shdr) or 0
+  U16           e_shnum;
+  U16           e_shstrndx;
+} Elf_head;
+
+static_assert(sizeof(Elf_head) == 64);
+
+typedef enum : U32 {
+  EPT_NULL         = 0,
+  EPT_LOAD         = 1,
+  EPT_DYNAMIC      = 2,
+  EPT_INTERP       = 3,
+  EPT_NOTE         = 4,
+  EPT_SHLIB        = 5,
+  EPT_PHDR         = 6,
+  EPT_TLS          = 7,
+  EPT_GNU_EH_FRAME = 0x6474E550,
+  EPT_GNU_STACK    = 0x6474E551,
+  EPT_GNU_RELRO    = 0x6474E552,
+} Elf_prog_type;
+
+typedef enum : U32 {
+  EPF_NONE  = 0,
+  EPF_EXEC  = 1u << 0u,
+  EPF_WRITE = 1u << 1u,
+  EPF_READ  = 1u << 2u,
+} Elf_prog_flag;
+
+/*
+`Elf64_Phdr` in `<elf.h>`.
+
+Analogous to Mach-O segment load commands (see `./mach_o.h`). The kernel
+and the dynamic linker map `EPT_LOAD` entries into memory; the rest are
+informational and usually point into memory covered by some `EPT_LOAD`.
+
+The kernel requires `p_offset % page == p_vaddr % page`. When `p_memsz`
+exceeds `p_filesz`, the rest is zero-filled, which is how we express the
+equivalent of Mach-O zerofill segments. `EPT_LOAD` entries must be sorted
+by `p_vaddr` in ascending order.
+*/
+typedef struct {
+  Elf_prog_type p_type;
+  Elf_prog_flag p_flags;
+  U64           p_offset; // From start of entire ELF file.
+  U64           p_vaddr;
+  U64           p_paddr; // Unused; conventionally same as `p_vaddr`.
+  U64           p_filesz;
+  U64           p_memsz;
+  U64           p_align;
+} Elf_prog_head;
+
+static_assert(sizeof(Elf_prog_head) == 56);
+
+typedef enum : S64 {
+  EDT_NULL     = 0,
+  EDT_NEEDED   = 1,
+  EDT_PLTRELSZ = 2,
+  EDT_PLTGOT   = 3,
+  EDT_HASH     = 4,
+  EDT_STRTAB   = 5,
+  EDT_SYMTAB   = 6,
+  EDT_RELA     = 7,
+  EDT_RELASZ   = 8,
+  EDT_RELAENT  = 9,
+  EDT_STRSZ    = 10,
+  EDT_SYMENT   = 11,
+  EDT_DEBUG    = 21,
+  EDT_TEXTREL  = 22,
+  EDT_JMPREL   = 23,
+  EDT_BIND_NOW = 24,
+  EDT_FLAGS    = 30,
+  EDT_FLAGS_1  = 0x6FFFFFFB,
+} Elf_dyn_tag;
+
+// Values for `EDT_FLAGS`.
+static constexpr U64 ELF_DF_BIND_NOW = 0x08;
+
+// Values for `EDT_FLAGS_1`.
+static constexpr U64 ELF_DF_1_NOW = 0x01;
+
+// `Elf64_Dyn` in `<elf.h>`. The `.dynamic` table ends with `EDT_NULL`.
+typedef struct {
+  Elf_dyn_tag d_tag;
+  U64         d_val; // Value or virtual address, depending on the tag.
+} Elf_dyn;
+
+static_assert(sizeof(Elf_dyn) == 16);
+
+// Values for the high nibble of `Elf_sym.st_info`.
+typedef enum : U8 {
+  ESB_LOCAL  = 0,
+  ESB_GLOBAL = 1,
+  ESB_WEAK   = 2,
+} Elf_sym_bind;
+
+// Values for the low nibble of `Elf_sym.st_info`.
+typedef enum : U8 {
+  EST_NOTYPE = 0,
+  EST_OBJECT = 1,
+  EST_FUNC   = 2,
+} Elf_sym_type;
+
+#define elf_sym_info(bind, type) (U8)(((U8)(bind) << 4u) | ((U8)(type) & 0xFu))
+
+// Value for `Elf_sym.st_shndx` of symbols defined elsewhere.
+static constexpr U16 ELF_SHN_UNDEF = 0;
+
+/*
+`Elf64_Sym` in `<elf.h>`. The `.dynsym` table begins with a zero entry;
+undefined (imported) symbols use `ELF_SHN_UNDEF` and a zero value.
+`st_name` is an offset in the `.dynstr` table.
+*/
+typedef struct {
+  U32 st_name;
+  U8  st_info;
+  U8  st_other;
+  U16 st_shndx;
+  U64 st_value;
+  U64 st_size;
+} Elf_sym;
+
+static_assert(sizeof(Elf_sym) == 24);
+
+// Relocation types for `EMT_AARCH64`; see the `aaelf64` link above.
+typedef enum : U32 {
+  ERT_AARCH64_NONE      = 0,
+  ERT_AARCH64_ABS64     = 257,
+  ERT_AARCH64_COPY      = 1024,
+  ERT_AARCH64_GLOB_DAT  = 1025,
+  ERT_AARCH64_JUMP_SLOT = 1026,
+  ERT_AARCH64_RELATIVE  = 1027,
+} Elf_reloc_type;
+
+#define elf_rela_info(sym, type) (((U64)(sym) << 32u) | (U64)(type))
+
+// `Elf64_Rela` in `<elf.h>`.
+typedef struct {
+  U64 r_offset; // Virtual address of the patched location.
+  U64 r_info;   // See `elf_rela_info`.
+  S64 r_addend;
+} Elf_rela;
+
+static_assert(sizeof(Elf_rela) == 24);
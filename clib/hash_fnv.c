@@ -22,6 +22,22 @@ ALLOW_OVERFLOW static Fnv_hash fnv_hash_str(const char *src) {
   return out;
 }
 
+/*
+Same as `fnv_hash_bytes` over the string's bytes, which are treated as
+unsigned so that both agree, but also measures the string in the same pass.
+*/
+ALLOW_OVERFLOW static Fnv_hash fnv_hash_str_len(const char *src, Ind *len) {
+  Fnv_hash   out = 0xCBF29CE484222325ull;
+  const auto beg = src;
+  Fnv_hash   val;
+  while ((val = (U8)*src++)) {
+    out ^= val;
+    out *= 0x00000100000001B3;
+  }
+  *len = (Ind)(src - beg - 1);
+  return out;
+}
+
 ALLOW_OVERFLOW static Fnv_hash fnv_hash_bytes(const U8 *src, Uint len) {
   Fnv_hash out = 0xCBF29CE484222325ull;
   for (Ind ind = 0; ind < len; ind++) {
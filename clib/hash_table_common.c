@@ -13,7 +13,10 @@ Common code for dicts, maps, and sometimes sets. In this codebase:
 #include "./misc.h"
 #include <stdlib.h>
 
-// One bit per entry, with no tombstones: our hash tables are append-only.
+/*
+One bit per entry, with no tombstones: maps and sets are append-only.
+Dicts support deletion via their own control bytes; see `./dict.c`.
+*/
 static constexpr U8 HASH_TABLE_BITS_SIZE = sizeof((Hash_table){}.bits);
 static constexpr U8 HASH_TABLE_BITS_CAP  = HASH_TABLE_BITS_SIZE * CHAR_BIT;
 static constexpr U8 HASH_TABLE_INIT_CAP  = 4;
@@ -117,6 +120,10 @@ static void hash_table_bits_set_at(Uint *bits, Ind ind) {
   bits[ind / HASH_TABLE_BITS_CAP] |= ((Uint)1 << (ind % HASH_TABLE_BITS_CAP));
 }
 
+static void hash_table_bits_del_at(Uint *bits, Ind ind) {
+  bits[ind / HASH_TABLE_BITS_CAP] &= ~((Uint)1 << (ind % HASH_TABLE_BITS_CAP));
+}
+
 // For loops.
 static Ind hash_table_next(const Hash_table *tab, Ind ind) {
   for (; ind < tab->cap; ind++) {
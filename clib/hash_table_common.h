@@ -5,7 +5,7 @@
 
 /*
 Opaque dict/map header. See `./dict.*` and `./map.*` files.
-Must be binary-compatible with `Dict` and `Map`.
+Must be binary-compatible with `Map` and with the prefix of `Dict`.
 
 SYNC[hash_table_structure].
 */
@@ -7,6 +7,7 @@
 #include <poll.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <termios.h>
 #include <unistd.h>
@@ -122,19 +123,12 @@ static Err err_file_not_regular(const char *path) {
   return errf("unable to read %s: not a regular file", path);
 }
 
-static Err file_read(const char *path, U8 **out_body, Uint *out_len) {
-  deferred(fd_deinit) int file = -1;
-  try(fd_open(path, O_RDONLY, &file));
-
-  struct stat info;
-  try(fd_stat(path, file, &info));
-
-  if (!S_ISREG(info.st_mode)) return err_file_not_regular(path);
-  try_assert(info.st_size >= 0);
-
-  const auto file_len = (Uint)info.st_size;
-  const auto buf_len  = ADD(file_len, 1);
-  U8        *buf      = malloc(buf_len);
+// Reads exactly `file_len` bytes into a new null-terminated buffer.
+static Err fd_read_alloc(
+  const char *path, int file, Uint file_len, U8 **out_body
+) {
+  const auto buf_len = ADD(file_len, 1);
+  U8        *buf     = malloc(buf_len);
 
   if (!buf) {
     return errf("unable to allocate " FMT_UINT " bytes for %s", buf_len, path);
@@ -149,7 +143,22 @@ static Err file_read(const char *path, U8 **out_body, Uint *out_len) {
 
   buf[file_len] = '\0';
   *out_body     = buf;
-  *out_len      = file_len;
+  return nullptr;
+}
+
+static Err file_read(const char *path, U8 **out_body, Uint *out_len) {
+  deferred(fd_deinit) int file = -1;
+  try(fd_open(path, O_RDONLY, &file));
+
+  struct stat info;
+  try(fd_stat(path, file, &info));
+
+  if (!S_ISREG(info.st_mode)) return err_file_not_regular(path);
+  try_assert(info.st_size >= 0);
+
+  const auto file_len = (Uint)info.st_size;
+  try(fd_read_alloc(path, file, file_len, out_body));
+  *out_len = file_len;
   return nullptr;
 }
 
@@ -254,6 +263,101 @@ static Err fd_read_available_text(
   return nullptr;
 }
 
+// Reads until EOF; for pipes, FIFOs, TTYs, and other unsized files.
+static Err fd_read_stream_text(
+  const char *path, int file, char **out_body, Uint *out_len
+) {
+  deferred(chars_deinit) char *body = nullptr;
+  Uint                         len  = 0;
+  char                         buf[4096];
+
+  for (;;) {
+    const auto read_len = read(file, buf, sizeof(buf));
+    if (!read_len) break;
+
+    if (read_len < 0) {
+      if (errno == EINTR) continue;
+      return err_file_unable_to_read_stream(path);
+    }
+
+    try(stream_append(path, &body, &len, buf, (Uint)read_len));
+  }
+
+  if (!body) {
+    body = calloc(1, 1);
+    if (!body) return errf("unable to allocate 1 byte for %s", path);
+  }
+
+  *out_body = body;
+  *out_len  = len;
+  body      = nullptr;
+  return nullptr;
+}
+
+/*
+Text of a whole file; always null-terminated. Either mapped, or read into
+a heap buffer. See `file_map_text`.
+
+Usage:
+
+  deferred(file_text_deinit) File_text text = {};
+*/
+typedef struct {
+  char *buf;
+  Uint  len;
+  Uint  map_len; // Non-zero when mapped; passed to `munmap`.
+} File_text;
+
+static void file_text_deinit(File_text *val) {
+  if (!val) return;
+  if (val->map_len) munmap(val->buf, val->map_len);
+  else free(val->buf);
+  *val = (File_text){};
+}
+
+/*
+Maps a regular file privately and read-only, avoiding a heap copy.
+Pages past the end of the file are zero-filled, which provides the null
+terminator, unless the file ends exactly on a page boundary. In that case,
+and for empty files, we read into a heap buffer like `file_read`. Unsized
+files such as pipes and TTYs are read until EOF.
+
+Truncating a file while it's mapped makes further reads fault with
+`SIGBUS`, so callers should unmap as soon as they're done.
+*/
+static Err file_map_text(const char *path, File_text *out) {
+  *out = (File_text){};
+
+  deferred(fd_deinit) int file = -1;
+  try(fd_open(path, O_RDONLY, &file));
+
+  struct stat info;
+  try(fd_stat(path, file, &info));
+
+  if (!S_ISREG(info.st_mode)) {
+    return fd_read_stream_text(path, file, &out->buf, &out->len);
+  }
+  try_assert(info.st_size >= 0);
+
+  const auto len  = (Uint)info.st_size;
+  const auto page = (Uint)getpagesize();
+
+  if (len && (len % page)) {
+    const auto buf = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // Some filesystems don't support mapping; reading still works.
+    if (buf != MAP_FAILED) {
+      (void)madvise(buf, len, MADV_SEQUENTIAL);
+      *out = (File_text){.buf = buf, .len = len, .map_len = len};
+      return nullptr;
+    }
+  }
+
+  try(fd_read_alloc(path, file, len, (U8 **)&out->buf));
+  out->len = len;
+  return nullptr;
+}
+
 static Err err_file_write(Uint exp, Uint act) {
   return errf(
     "stream write error: " FMT_UINT " objects written instead of " FMT_UINT,
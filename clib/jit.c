@@ -1,3 +1,9 @@
+/*
+JIT code memory. The code region has two addresses: `exec` for execution and
+`write` for writing. Depending on the platform, they may or may not coincide;
+callers must write via `write` between `jit_before_write` and `jit_after_write`
+and execute via `exec`, and must not assume either way.
+*/
 #pragma once
 #include "./err.c"
 #include "./mem.c"
@@ -10,8 +16,8 @@
 #include <libkern/OSCacheControl.h>
 #include <pthread.h>
 
-static Err mem_map_jit(Ind len, void **out) {
-  const auto ptr = mem_map(len, MAP_JIT);
+static Err mem_map_jit(void *addr, Ind len, void **out) {
+  const auto ptr = mem_map_at(addr, len, MAP_JIT);
   if (ptr == MAP_FAILED) return err_mmap();
   *out = ptr;
   return nullptr;
@@ -24,58 +30,257 @@ static Err mem_map_jit(Ind len, void **out) {
 /*
 Should be used when initializing a JIT code heap, which must be memory-mapped
 with the `MAP_JIT` flag. The last `pthread_jit_write_protect_np` determines
-whether the region is executable or writable.
-
-TODO clearer API.
+whether the region is executable or writable, so both views are the same.
 */
-static Err mprotect_jit(void *addr, Ind len) {
-  return err_errno(mprotect(addr, len, PROT_READ | PROT_WRITE | PROT_EXEC));
+static Err jit_code_init(void *exec, Ind len, void **write) {
+  *write = exec;
+  return err_errno(mprotect(exec, len, PROT_READ | PROT_WRITE | PROT_EXEC));
 }
 
 // NOLINTEND(clang-analyzer-security.MmapWriteExec)
 
+static Err jit_code_deinit(void *exec, void *write, Ind len) {
+  (void)exec;
+  (void)write;
+  (void)len;
+  return nullptr;
+}
+
 // TODO consider using `pthread_jit_write_with_callback_np` instead.
-static Err jit_before_write(void *addr, Ind len) {
-  (void)addr;
+static Err jit_before_write(void *exec, void *write, Ind len) {
+  (void)exec;
+  (void)write;
   (void)len;
   pthread_jit_write_protect_np(false);
   return nullptr;
 }
 
-static Err jit_after_write(void *addr, Ind len) {
+static Err jit_after_write(void *exec, void *write, Ind len) {
+  (void)write;
   pthread_jit_write_protect_np(true);
-  sys_icache_invalidate(addr, len);
+  sys_icache_invalidate(exec, len);
   return nullptr;
 }
 
 #else // __APPLE__
 
-/*
-The stuff below also seems to work on MacOS Apple Silicon,
-so the `__APPLE__` case above might be unnecessary.
-*/
-
-#include "./err.c"
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
 #include <sys/types.h>
+#include <unistd.h>
 
-static Err mem_map_jit(Ind len, void **out) {
-  const auto ptr = mem_map(len, 0);
+static Err mem_map_jit(void *addr, Ind len, void **out) {
+  const auto ptr = mem_map_at(addr, len, 0);
   if (ptr == MAP_FAILED) return err_mmap();
   *out = ptr;
   return nullptr;
 }
 
-static Err mprotect_jit(void *addr, Ind len) {
-  return err_errno(mprotect(addr, len, PROT_READ | PROT_EXEC));
+/*
+The memfd-backed code region, if any; see `jit_code_init`. Views of a shared
+file stay shared across `fork`, so without intervention, JIT writes in either
+process would overwrite code which the other one is running. The `jit_fork_*`
+handlers give the child its own copy. Only one region is tracked, which is
+all the interpreter needs.
+*/
+typedef struct {
+  void *exec;
+  void *write;
+  Ind   len;
+  int   fdes;      // Backing memfd; kept open for snapshots.
+  int   fork_fdes; // Snapshot for the child of a pending `fork`, or -1.
+} Jit_shared;
+
+static Jit_shared JIT_SHARED      = {.fdes = -1, .fork_fdes = -1};
+static bool       JIT_FORK_HOOKED = false;
+
+/*
+Copies the ranges of `src` which are backed by pages. The rest of the region
+reads as zeros anyway, and is typically most of it, since the code heap is
+reserved far larger than it's used.
+*/
+static bool jit_copy_pages(int src, int tar, const U8 *view, off_t len) {
+  off_t off = 0;
+
+  while (off < len) {
+    off = lseek(src, off, SEEK_DATA);
+    if (off < 0) return errno == ENXIO; // No data past `off`.
+
+    const auto end = lseek(src, off, SEEK_HOLE);
+    if (end < 0) return false;
+
+    while (off < end) {
+      const auto out = pwrite(tar, view + off, (size_t)(end - off), off);
+      if (out <= 0) return false;
+      off += out;
+    }
+  }
+  return true;
+}
+
+/*
+Runs in the parent right before `fork`, so the snapshot reflects the code at
+the moment of forking, regardless of what the parent writes afterwards.
+*/
+static void jit_fork_prepare() {
+  const auto jit = &JIT_SHARED;
+  if (jit->fdes < 0) return;
+
+  const auto fdes = memfd_create("jit", MFD_CLOEXEC);
+  if (fdes < 0) return;
+
+  const auto len = (off_t)jit->len;
+  if (
+    ftruncate(fdes, len) || !jit_copy_pages(jit->fdes, fdes, jit->exec, len)
+  ) {
+    close(fdes);
+    return;
+  }
+  jit->fork_fdes = fdes;
+}
+
+static void jit_fork_parent() {
+  const auto jit = &JIT_SHARED;
+  if (jit->fork_fdes < 0) return;
+
+  close(jit->fork_fdes);
+  jit->fork_fdes = -1;
+}
+
+static void jit_fork_write_err(const char *msg) {
+  (void)!write(STDERR_FILENO, msg, strlen(msg));
+}
+
+/*
+Maps the snapshot over both views at their existing addresses, so pointers
+into either view remain valid in the child.
+*/
+static void jit_fork_child() {
+  const auto jit  = &JIT_SHARED;
+  const auto fdes = jit->fork_fdes;
+  if (jit->fdes < 0) return;
+
+  if (fdes < 0) {
+    jit_fork_write_err(
+      "[system] unable to copy JIT code for the forked process; "
+      "JIT code remains shared with the parent\n"
+    );
+    return;
+  }
+
+  const auto len   = jit->len;
+  const auto mflag = MAP_SHARED | MAP_FIXED;
+  const auto rx    = PROT_READ | PROT_EXEC;
+  const auto rw    = PROT_READ | PROT_WRITE;
+  const auto exec  = mmap(jit->exec, len, rx, mflag, fdes, 0);
+  const auto view  = mmap(jit->write, len, rw, mflag, fdes, 0);
+
+  if (exec == MAP_FAILED || view == MAP_FAILED) {
+    jit_fork_write_err(
+      "[system] unable to remap JIT code in the forked process\n"
+    );
+  }
+
+  close(jit->fdes);
+  jit->fdes      = fdes;
+  jit->fork_fdes = -1;
+}
+
+/*
+Backs the code region with an anonymous shared-memory file mapped twice:
+read-execute at `exec` (replacing the existing reservation), and read-write
+at a kernel-chosen address. The process never holds a mapping which is both
+writable and executable, yet writes require no `mprotect`, so there are no
+syscalls or TLB shootdowns on the hot path; only cache maintenance.
+
+When the memfd route is unavailable (old kernels, sandboxes, exotic mounts),
+falls back to flipping the protection of a single view with `mprotect`. That
+view is a private mapping, which `fork` already copies; the memfd views need
+the `jit_fork_*` handlers, and use the fallback when those can't be set up.
+*/
+static Err jit_code_init(void *exec, Ind len, void **write) {
+  *write = exec;
+
+  if (!JIT_FORK_HOOKED) {
+    JIT_FORK_HOOKED = !pthread_atfork(
+      jit_fork_prepare, jit_fork_parent, jit_fork_child
+    );
+  }
+
+  const auto fdes = JIT_FORK_HOOKED ? memfd_create("jit", MFD_CLOEXEC) : -1;
+  if (fdes < 0) {
+    return err_errno(mprotect(exec, len, PROT_READ | PROT_EXEC));
+  }
+
+  // Sizing can fail under `RLIMIT_FSIZE` or a full `/dev/shm`. Nothing has
+  // been remapped yet, so the single-view fallback still applies.
+  if (ftruncate(fdes, len)) {
+    close(fdes);
+    return err_errno(mprotect(exec, len, PROT_READ | PROT_EXEC));
+  }
+
+  Err        err  = nullptr;
+  const auto view = mmap(
+    exec, len, PROT_READ | PROT_EXEC, MAP_SHARED | MAP_FIXED, fdes, 0
+  );
+  if (view == MAP_FAILED) err = err_mmap();
+
+  if (!err) {
+    const auto ptr = mmap(
+      nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fdes, 0
+    );
+    if (ptr == MAP_FAILED) err = err_mmap();
+    else *write = ptr;
+  }
+
+  if (err) {
+    close(fdes);
+    return err;
+  }
+
+  JIT_SHARED = (Jit_shared){
+    .exec      = exec,
+    .write     = *write,
+    .len       = len,
+    .fdes      = fdes,
+    .fork_fdes = -1,
+  };
+  return nullptr;
+}
+
+static Err jit_code_deinit(void *exec, void *write, Ind len) {
+  if (!write || write == exec) return nullptr;
+
+  const auto jit = &JIT_SHARED;
+  if (jit->exec == exec) {
+    close(jit->fdes);
+    *jit = (Jit_shared){.fdes = -1, .fork_fdes = -1};
+  }
+  return err_errno(munmap(write, len));
+}
+
+static bool jit_code_aliased(const void *exec, const void *write) {
+  return exec != write;
+}
+
+// Used only in the single-view fallback; see `jit_code_init`.
+static Err jit_code_protect(void *exec, Ind len, int pflag) {
+  const auto beg = __builtin_align_down((U8 *)exec, MEM_PAGE);
+  const auto end = __builtin_align_up((U8 *)exec + len, MEM_PAGE);
+  return mem_protect(beg, (Ind)(end - beg), pflag);
 }
 
-static Err jit_before_write(void *addr, Ind len) {
-  return err_errno(mprotect(addr, len, PROT_READ | PROT_WRITE));
+static Err jit_before_write(void *exec, void *write, Ind len) {
+  if (jit_code_aliased(exec, write)) return nullptr;
+  return jit_code_protect(exec, len, PROT_READ | PROT_WRITE);
 }
 
-static Err jit_after_write(void *addr, Ind len) {
-  try(mprotect_jit(addr, len));
-  __builtin___clear_cache(addr, (void *)((U8 *)addr + len));
+static Err jit_after_write(void *exec, void *write, Ind len) {
+  if (!jit_code_aliased(exec, write)) {
+    try(jit_code_protect(exec, len, PROT_READ | PROT_EXEC));
+  }
+  __builtin___clear_cache(exec, (char *)exec + len);
   return nullptr;
 }
 
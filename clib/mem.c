@@ -87,6 +87,33 @@ static void *mem_map(Ind len, int mflag) {
   return mmap(nullptr, len, PROT_NONE, mflag, fdes, off);
 }
 
+/*
+Variant of `mem_map` which requires the mapping to begin exactly at the given
+address, without clobbering any existing mappings. Used for restoring state
+which contains absolute addresses. When the address is `nullptr`, this is
+equivalent to `mem_map`. When the range is unavailable, returns `MAP_FAILED`
+with `errno = EEXIST`; the caller handles this as usual:
+
+  const auto ptr = mem_map_at(some_addr, some_size, some_mflags);
+  if (ptr == MAP_FAILED) return err_mmap();
+*/
+static void *mem_map_at(void *addr, Ind len, int mflag) {
+  if (!addr) return mem_map(len, mflag);
+
+  // NOLINTBEGIN(hicpp-signed-bitwise)
+  mflag |= MAP_ANON | MAP_PRIVATE;
+  // NOLINTEND(hicpp-signed-bitwise)
+
+  // Without `MAP_FIXED`, the address is only a hint, which is what we want:
+  // the kernel never replaces existing mappings, and we check the outcome.
+  const auto ptr = mmap(addr, len, PROT_NONE, mflag, -1, 0);
+  if (ptr == MAP_FAILED || ptr == addr) return ptr;
+
+  munmap(ptr, len);
+  errno = EEXIST;
+  return MAP_FAILED;
+}
+
 static Err mem_protect(void *addr, Ind len, int pflag) {
   return err_errno(mprotect(addr, len, pflag));
 }
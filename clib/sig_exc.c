@@ -0,0 +1,143 @@
+/*
+Tools for handling synchronous hardware faults (SIGSEGV, SIGBUS) via POSIX
+signals. This is the non-Darwin counterpart of `./mach_exc.c`: instead of
+delivering exceptions to a server thread, the kernel runs the handler on the
+faulting thread, on an alternate signal stack, since the regular stack may
+be the very thing that overflowed.
+
+Signal handlers may only call async-signal-safe functions. Notably, they must
+not allocate, and must not use stdio, which may allocate and take locks. The
+`sig_write_*` functions below format directly into `write(2)` calls.
+
+Links:
+
+  - https://man7.org/linux/man-pages/man2/sigaction.2.html
+  - https://man7.org/linux/man-pages/man2/sigaltstack.2.html
+  - https://man7.org/linux/man-pages/man7/signal-safety.7.html
+*/
+#pragma once
+#include "./arr.h"
+#include "./err.c" // IWYU pragma: export
+#include "./num.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef void(Sig_handler)(int sig, siginfo_t *info, void *uctx);
+
+/*
+Backing memory for the alternate signal stack of each thread; see
+`sig_thread_init`. Static, so that installing the handler doesn't depend on
+allocation either; `SIGSTKSZ` isn't a constant expression in recent glibc,
+so we reserve a generous fixed size.
+*/
+static thread_local U8 SIG_ALT_STACK[1u << 16u];
+
+// Set by `sig_exception_init`; until then, new threads don't need stacks.
+static bool SIG_EXC_INITED;
+
+static void sig_write_str(const char *src) {
+  if (!src) return;
+  (void)!write(STDERR_FILENO, src, strlen(src));
+}
+
+static void sig_write_uint(U64 val, U8 radix) {
+  char buf[24];
+  auto top = arr_ceil(buf);
+
+  do {
+    const auto dig = (U8)(val % radix);
+    *--top         = (char)(dig < 10 ? '0' + dig : 'a' + dig - 10);
+    val /= radix;
+  } while (val && top > buf);
+
+  (void)!write(STDERR_FILENO, top, (size_t)(arr_ceil(buf) - top));
+}
+
+static void sig_write_ptr(const void *val) {
+  sig_write_str("0x");
+  sig_write_uint((U64)val, 16);
+}
+
+/*
+Gives up on handling the signal: restores the default disposition, and lets
+the faulting instruction run again, which terminates the process the usual
+way (with a core dump where enabled), and with the correct exit status.
+*/
+static void sig_exception_fallback(int sig) {
+  struct sigaction act = {.sa_handler = SIG_DFL};
+  sigemptyset(&act.sa_mask);
+  sigaction(sig, &act, nullptr);
+}
+
+/*
+Registers the alternate signal stack of the calling thread. The kernel keeps
+one per thread, and a thread without one can't run the handler when its own
+stack overflows; the process then dies without any message.
+*/
+static Err sig_thread_init() {
+  const stack_t stack = {
+    .ss_sp   = SIG_ALT_STACK,
+    .ss_size = sizeof(SIG_ALT_STACK),
+  };
+  return err_errno(sigaltstack(&stack, nullptr));
+}
+
+/*
+Installs the given handler for "bad memory access" signals in the current
+process, running on an alternate stack. Failure is non-lethal; the caller
+may continue without exception handling.
+
+Covers the calling thread. Threads spawned later are covered when they're
+created via `sig_pthread_create`.
+*/
+static Err sig_exception_init(Sig_handler *fun) {
+  try(sig_thread_init());
+
+  struct sigaction act = {
+    .sa_sigaction = fun,
+    .sa_flags     = SA_SIGINFO | SA_ONSTACK,
+  };
+  sigemptyset(&act.sa_mask);
+
+  try_errno(sigaction(SIGSEGV, &act, nullptr));
+  try_errno(sigaction(SIGBUS, &act, nullptr));
+  SIG_EXC_INITED = true;
+  return nullptr;
+}
+
+typedef void *(Sig_thread_fun)(void *inp);
+
+typedef struct {
+  Sig_thread_fun *fun;
+  void           *inp;
+} Sig_thread_run;
+
+static void *sig_thread_run(void *val) {
+  const auto run = *(Sig_thread_run *)val;
+  free(val);
+
+  // Non-lethal like in `sig_exception_init`; the thread just isn't covered.
+  if (SIG_EXC_INITED) (void)sig_thread_init();
+  return run.fun(run.inp);
+}
+
+/*
+Drop-in replacement for `pthread_create` which registers an alternate signal
+stack in the new thread before running `fun`, so that many threads faulting
+at once each run the handler on their own stack.
+*/
+static int sig_pthread_create(
+  pthread_t *thread, const pthread_attr_t *attr, Sig_thread_fun *fun, void *inp
+) {
+  const auto run = (Sig_thread_run *)malloc(sizeof(Sig_thread_run));
+  if (!run) return EAGAIN;
+  *run = (Sig_thread_run){.fun = fun, .inp = inp};
+
+  const auto code = pthread_create(thread, attr, sig_thread_run, run);
+  if (code) free(run);
+  return code;
+}
@@ -57,7 +57,7 @@ static Err stack_init_impl(void *out, Stack_opt *opt, Ind val_size) {
   const auto data_size  = __builtin_align_up(MUL(val_size, len), page_size);
   const auto total_size = page_size + data_size + page_size;
 
-  const auto cellar = mem_map(total_size, 0);
+  const auto cellar = mem_map_at(opt->addr, total_size, 0);
   if (cellar == MAP_FAILED) return err_mmap();
 
   const auto floor = (U8 *)cellar + page_size;
@@ -6,7 +6,8 @@
 #include <string.h>
 
 typedef struct {
-  Ind len;
+  Ind   len;
+  void *addr; // Optional exact address of the mapping, including guards.
 } Stack_opt;
 
 // SYNC[span_fields].
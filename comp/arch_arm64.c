@@ -53,11 +53,9 @@ bitfield layout is implementation-defined and non-portable.
 #include "../clib/misc.h"
 #include "../clib/stack.c"
 #include "./comp.h"
+#include "./instr_region.c"
 #include "./sym.c"
-
-static bool comp_code_is_instr_ours(const Comp_code *code, const Instr *addr) {
-  return is_stack_elem(&code->code_exec, addr);
-}
+#include <string.h>
 
 /*
 Prog counter is the next instruction in `Comp_heap.exec`.
@@ -79,54 +77,6 @@ static Instr *comp_code_next_writable_instr(const Comp_code *code) {
   return write->top < write->ceil ? write->top : nullptr;
 }
 
-static const Instr *comp_sym_exec_instr(const Comp *comp, const Sym *sym) {
-  IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
-  const auto exec = &comp->code.code_exec;
-  const auto ind  = sym->norm.spans.prologue;
-  return ind < stack_len_valid(exec) ? &exec->floor[ind] : nullptr;
-}
-
-static Err comp_code_sync(Comp_code *code) {
-  const auto valid_len = code->valid_instr_len;
-  const auto write     = &code->code_write;
-  const auto exec      = &code->code_exec;
-  const auto exec_len  = stack_len_valid(exec);
-  const auto diff      = valid_len - exec_len;
-
-  if (diff <= 0) return nullptr;
-
-  const auto beg = exec->top;
-  const auto end = beg + diff;
-  const auto len = (U8 *)end - (U8 *)beg;
-  try_assert(len > 0 && len < IND_MAX);
-
-  // This alignment is only needed when `../clib/jit.c` uses `mprotect`.
-  const auto page_beg = __builtin_align_down(beg, MEM_PAGE);
-  const auto page_end = __builtin_align_up(end, MEM_PAGE);
-  const auto page_len = (U8 *)page_end - (U8 *)page_beg;
-  try_assert(page_len > 0 && page_len < IND_MAX);
-
-  IF_DEBUG({
-    try_assert(page_beg >= exec->floor);
-    try_assert(page_end <= exec->ceil);
-    try_assert(page_len > 0);
-    try_assert(page_beg <= beg);
-    try_assert(end <= page_end);
-  });
-
-  try(jit_before_write(page_beg, (Ind)page_len));
-  memcpy(beg, &write->floor[exec_len], (Ind)len);
-  try(jit_after_write(page_beg, (Ind)page_len));
-
-  exec->top = exec->floor + valid_len;
-  return nullptr;
-}
-
-static bool comp_code_is_sym_ready(const Comp_code *code, const Sym *sym) {
-  IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
-  return stack_len_valid(&code->code_exec) >= sym->norm.spans.ceil;
-}
-
 static Err err_sym_not_ready(const char *name) {
   return errf(
     "internal error: unable to call " FMT_QUOTED
@@ -270,6 +220,58 @@ static Err imm_signed(Sint src, U8 wid, Instr *out) {
   return nullptr;
 }
 
+/*
+Variant of `asm_call_extern` for externs with `F64` parameters, declared via
+`.extern_float`. Floats are passed around as bit patterns in cells; here we
+sort the inputs into GPR and FP arguments, and C does the rest.
+*/
+static Err asm_call_extern_float(Sint_span *stack, const Sym *sym) {
+  const auto inp_len = sym->inp_len;
+  try_assert(inp_len <= ASM_INP_PARAM_REG_LEN);
+  try_assert(sym->out_len <= 1);
+
+  Sint inps[ASM_INP_PARAM_REG_LEN] = {};
+  for (auto ind = inp_len; ind > 0; ind--) {
+    try(cell_stack_pop(stack, &inps[ind - 1]));
+  }
+
+  Sint ints[8] = {};
+  F64  flts[8] = {};
+  U8   int_len = 0;
+  U8   flt_len = 0;
+
+  for (U8 ind = 0; ind < inp_len; ind++) {
+    if ((sym->flt_inps >> ind) & 1u) {
+      memcpy(&flts[flt_len++], &inps[ind], sizeof(F64));
+    }
+    else {
+      ints[int_len++] = inps[ind];
+    }
+  }
+
+  Sint out;
+
+  // Unused inputs are harmless.
+  if (sym->flt_out) {
+    const auto fun = (Extern_fun_flt_out *)sym->exter;
+    const auto val = fun(
+      ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7],
+      flts[0], flts[1], flts[2], flts[3], flts[4], flts[5], flts[6], flts[7]
+    );
+    memcpy(&out, &val, sizeof(out));
+  }
+  else {
+    const auto fun = (Extern_fun_flt_inp *)sym->exter;
+    out            = fun(
+      ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7],
+      flts[0], flts[1], flts[2], flts[3], flts[4], flts[5], flts[6], flts[7]
+    );
+  }
+
+  if (sym->out_len) try(cell_stack_push(stack, out));
+  return nullptr;
+}
+
 /*
 We assume we're calling a C function, and we're doing that from C
 which limits us to just 1 output, despite more supported by Arm64.
@@ -281,6 +283,7 @@ Note: this works identically for both of our callventions.
 */
 static Err asm_call_extern(Sint_span *stack, const Sym *sym) {
   try_assert(sym->type == SYM_EXTERN);
+  if (sym->flt_inps || sym->flt_out) return asm_call_extern_float(stack, sym);
 
   const auto fun     = (Extern_fun *)sym->exter;
   const auto inp_len = sym->inp_len;
@@ -313,7 +316,13 @@ static Err asm_call_extern(Sint_span *stack, const Sym *sym) {
 }
 
 static Instr *asm_append_instr(Comp *comp, Instr val) {
-  return stack_push(&comp->code.code_write, val);
+  const auto code = &comp->code;
+  const auto len  = stack_len_valid(&code->code_write);
+
+  if (len >= code->instr_commit) {
+    try_fatal(comp_code_commit(code, code->region, len + 1));
+  }
+  return stack_push(&code->code_write, val);
 }
 
 /*
@@ -467,8 +476,8 @@ static void asm_append_load_unscaled_offset(
 }
 
 /*
-Appends `adrp <reg>, <imm>` which calculates an imprecise address and stores it
-in `reg`; the resulting address is aligned to 4096 bytes. Returns the remaining
+Encodes `adrp <reg>, <imm>` which calculates an imprecise address and stores it
+in `reg`; the resulting address is aligned to 4096 bytes. Outputs the remaining
 distance towards the desired address, counted in bytes, which should be used by
 a subsequent instruction such as `ldr` or `add`.
 
@@ -476,19 +485,20 @@ The offset is pseudo-PC-relative and implicitly multiplied by 4096.
 The instruction implicitly treats the low 12 bits of the PC as zeros.
 The immediate has a unique encoding: its lowest 2 bits are placed
 separately in the high bits of the instruction in the opcode region.
+
+`prog` is the address where the instruction is going to be executed.
 */
-static U16 asm_append_adrp(Comp *comp, U8 reg, Uint addr) {
+static Instr asm_instr_adrp(U8 reg, Uint prog, Uint addr, U16 *pageoff) {
   constexpr Uint bits = 12;
   constexpr Uint mask = (1u << bits) - 1u; // 0b111111111111 = 4095
 
-  const auto prog      = (Uint)(comp_code_next_prog_counter(&comp->code));
   const auto pc_page   = prog & ~mask;
   const auto addr_page = addr & ~mask;
   const auto page_diff = (Sint)(addr_page >> bits) - (Sint)(pc_page >> bits);
-  const auto pageoff   = addr - addr_page;
 
   assert_fatal(addr >= addr_page);
-  assert_fatal(pageoff < (1u << bits));
+  assert_fatal(addr - addr_page < (1u << bits));
+  if (pageoff) *pageoff = (U16)(addr - addr_page);
 
   Instr imm;
   try_fatal(imm_signed(page_diff, 21, &imm));
@@ -496,13 +506,17 @@ static U16 asm_append_adrp(Comp *comp, U8 reg, Uint addr) {
   const Instr high = imm >> 2u;
   const Instr low  = imm & 0b11u;
 
-  asm_append_instr(
-    comp,
-    // adrp <reg>, <imm>
-    (Instr)0b1'00'100'00'0000000000000000000'00000 | (low << 29u) |
-      (high << 5u) | reg
-  );
-  return (U16)pageoff;
+  // adrp <reg>, <imm>
+  return (Instr)0b1'00'100'00'0000000000000000000'00000 | (low << 29u) |
+    (high << 5u) | reg;
+}
+
+// Appends `adrp`; see `asm_instr_adrp`. Returns the page offset.
+static U16 asm_append_adrp(Comp *comp, U8 reg, Uint addr) {
+  const auto prog = (Uint)(comp_code_next_prog_counter(&comp->code));
+  U16        pageoff;
+  asm_append_instr(comp, asm_instr_adrp(reg, prog, addr, &pageoff));
+  return pageoff;
 }
 
 /*
@@ -561,6 +575,27 @@ static void asm_append_load_store_pair(
   );
 }
 
+/*
+Same as `asm_instr_load_store_pair`, but for 128-bit vector registers
+`q0` … `q31`, with the offset implicitly a multiple of 16.
+*/
+static Instr asm_instr_load_store_pair_q(
+  Instr opc, U8 reg0, U8 reg1, U8 addr_reg, Sint off
+) {
+  assert_fatal(off >= -1024 && off <= 1008); // See Arm64 docs.
+  assert_fatal(divisible_by(off, 16));
+  off /= 16;
+
+  Instr off_val;
+  try_fatal(imm_signed(off, 7, &off_val));
+  try_fatal(asm_validate_reg(reg0));
+  try_fatal(asm_validate_reg(reg1));
+  try_fatal(asm_validate_reg(addr_reg));
+
+  return (Instr)0b10'101'1'001'0'0000000'00000'00000'00000 | (opc << 22u) |
+    (off_val << 15u) | ((Instr)reg1 << 10u) | ((Instr)addr_reg << 5u) | reg0;
+}
+
 // The offset is PC-relative and implicitly times 4.
 static Instr asm_instr_branch_to_offset(Sint off) {
   Instr imm;
@@ -596,6 +631,13 @@ static void asm_append_branch_link_to_reg(Comp *comp, U8 reg) {
   asm_append_instr(comp, base | ((Instr)reg << 5u));
 }
 
+// br <reg>
+static Instr asm_instr_branch_to_reg(U8 reg) {
+  try_fatal(asm_validate_reg(reg));
+  const auto base = (Instr)0b110'101'1'0'0'00'11111'0000'0'0'00000'00000;
+  return base | ((Instr)reg << 5u);
+}
+
 static Instr asm_instr_compare_branch(U8 reg, Sint off, bool non_zero) {
   try_fatal(asm_validate_reg(reg));
 
@@ -630,7 +672,7 @@ static Instr *asm_sym_prologue_writable(const Comp *comp, const Sym *sym) {
 static Instr *asm_sym_prologue_executable(const Comp *comp, const Sym *sym) {
   assert_fatal(sym->type == SYM_NORM);
   const auto span = &comp->code.code_exec;
-  assert_fatal(sym->norm.spans.prologue < stack_cap_valid(span));
+  assert_fatal(sym->norm.spans.prologue < INSTR_HEAP_LEN);
   return &span->floor[sym->norm.spans.prologue];
 }
 
@@ -816,6 +858,12 @@ static void asm_reserve_sym_prologue(Comp *comp) {
     asm_append_breakpoint(comp, ASM_CODE_PROLOGUE);
   }
 
+  // Same for callee-saved vector registers.
+  len = ASM_VEC_STABLE_REG_LEN;
+  while ((len -= 2) >= 0) {
+    asm_append_breakpoint(comp, ASM_CODE_PROLOGUE);
+  }
+
 #endif // CALL_CONV_STACK
 
   asm_append_breakpoint(comp, ASM_CODE_PROLOGUE);
@@ -837,7 +885,9 @@ static void asm_fixup_sym_prologue(Comp *comp, Sym *sym, Ind *instr_floor) {
 #ifdef CALL_CONV_STACK
   static constexpr U8 len = 3;
 #else
-  static constexpr U8 len = 3 + (__builtin_align_up(ASM_STABLE_REG_LEN, 2) / 2);
+  static constexpr U8 len = 3 +
+    (__builtin_align_up(ASM_STABLE_REG_LEN, 2) / 2) +
+    (ASM_VEC_STABLE_REG_LEN / 2);
 #endif
 
   IF_DEBUG({
@@ -899,6 +949,18 @@ static void asm_fixup_sym_prologue(Comp *comp, Sym *sym, Ind *instr_floor) {
     *--floor = asm_instr_load_store_pre_post(false, saved, ASM_REG_SP, -16);
   }
 
+  // Stash callee-saved vector registers, in whole pairs.
+  for (U8 reg = ASM_VEC_STABLE_REG_FIRST + ASM_VEC_STABLE_REG_LEN;
+       reg > ASM_VEC_STABLE_REG_FIRST;) {
+    reg -= 2;
+    if (!bits_has_some(ctx->vec_saved, (Bits)0b11 << reg)) continue;
+
+    // stp <reg0>, <reg1>, [sp, -32]!
+    *--floor = asm_instr_load_store_pair_q(
+      ASM_STORE_PAIR_PRE, reg, reg + 1, ASM_REG_SP, -32
+    );
+  }
+
 #endif // CALL_CONV_STACK
 
   *instr_floor = (Ind)(floor - instrs->floor);
@@ -927,16 +989,15 @@ static bool asm_skipped_prologue_instr(Comp *comp, Sym *sym, Instr *instr) {
 // TODO restructure to avoid the need for forward declarations.
 static void asm_append_sym_epilogue_ok(Comp *, Sym *);
 
-// SYNC[asm_prologue_epilogue].
-static void asm_append_sym_epilogue(Comp *comp, Sym *sym) {
+/*
+Tears down what the prologue set up. Used at the end of the epilogue,
+and before tail calls; see `asm_fixup_tail`.
+
+SYNC[asm_prologue_epilogue].
+*/
+static void asm_append_sym_frame_pop(Comp *comp, const Sym *sym) {
   const auto sp_off = asm_sp_off(comp->ctx.fp_off);
   const bool frame  = !is_sym_leaf(sym) || sp_off || sym->norm.has_alloca;
-  const auto spans  = &sym->norm.spans;
-  const auto write  = &comp->code.code_write;
-
-  spans->epi_ok = stack_len_valid(write);
-  asm_append_sym_epilogue_ok(comp, sym);
-  spans->epi_err = stack_len_valid(write);
 
   // SYNC[asm_sp_off].
   if (frame) {
@@ -984,9 +1045,35 @@ static void asm_append_sym_epilogue(Comp *comp, Sym *sym) {
     asm_append_load_store_pre_post(comp, true, saved, ASM_REG_SP, 16);
   }
 
+  // Restore callee-saved vector registers, in reverse order of stashing.
+  for (U8 reg = ASM_VEC_STABLE_REG_FIRST + ASM_VEC_STABLE_REG_LEN;
+       reg > ASM_VEC_STABLE_REG_FIRST;) {
+    reg -= 2;
+    if (!bits_has_some(ctx->vec_saved, (Bits)0b11 << reg)) continue;
+
+    // ldp <reg0>, <reg1>, [sp], 32
+    asm_append_instr(
+      comp,
+      asm_instr_load_store_pair_q(
+        ASM_LOAD_PAIR_POST, reg, reg + 1, ASM_REG_SP, 32
+      )
+    );
+  }
+
 #endif // CALL_CONV_STACK
 }
 
+// SYNC[asm_prologue_epilogue].
+static void asm_append_sym_epilogue(Comp *comp, Sym *sym) {
+  const auto spans = &sym->norm.spans;
+  const auto write = &comp->code.code_write;
+
+  spans->epi_ok = stack_len_valid(write);
+  asm_append_sym_epilogue_ok(comp, sym);
+  spans->epi_err = stack_len_valid(write);
+  asm_append_sym_frame_pop(comp, sym);
+}
+
 static Instr asm_instr_mov_reg(U8 tar_reg, U8 src_reg) {
   try_fatal(asm_validate_reg(tar_reg));
   try_fatal(asm_validate_reg(src_reg));
@@ -1000,6 +1087,30 @@ static void asm_append_mov_reg(Comp *comp, U8 tar_reg, U8 src_reg) {
   asm_append_instr(comp, asm_instr_mov_reg(tar_reg, src_reg));
 }
 
+// fmov Dd, Xn
+static void asm_append_fmov_to_fp(Comp *comp, U8 tar_reg, U8 src_reg) {
+  try_fatal(asm_validate_reg(tar_reg));
+  try_fatal(asm_validate_reg(src_reg));
+
+  asm_append_instr(
+    comp,
+    (Instr)0b1'00'11110'01'1'00'111'000000'00000'00000 |
+      ((Instr)src_reg << 5u) | (Instr)tar_reg
+  );
+}
+
+// fmov Xd, Dn
+static void asm_append_fmov_from_fp(Comp *comp, U8 tar_reg, U8 src_reg) {
+  try_fatal(asm_validate_reg(tar_reg));
+  try_fatal(asm_validate_reg(src_reg));
+
+  asm_append_instr(
+    comp,
+    (Instr)0b1'00'11110'01'1'00'110'000000'00000'00000 |
+      ((Instr)src_reg << 5u) | (Instr)tar_reg
+  );
+}
+
 /*
 ARM64 move-wide instructions encode one 16-bit lane. `movz` and `movn`
 initialize all lanes to zero or ones; `movk` replaces one lane. This emits
@@ -1108,9 +1219,13 @@ static void asm_append_fixup_throw(Comp *comp) {
   );
 }
 
+/*
+The `add` is emitted even when the page offset is zero: AOT tree shaking
+relocates data and must be able to patch the offset; see `./link.c`.
+*/
 static void asm_append_page_addr(Comp *comp, U8 reg, Uint adr) {
   const auto pageoff = asm_append_adrp(comp, reg, adr);
-  if (pageoff) asm_append_add_imm(comp, reg, reg, pageoff);
+  asm_append_add_imm(comp, reg, reg, pageoff);
 }
 
 static void asm_append_page_load(Comp *comp, U8 reg, Uint adr) {
@@ -1118,6 +1233,17 @@ static void asm_append_page_load(Comp *comp, U8 reg, Uint adr) {
   asm_append_load_scaled_offset(comp, reg, reg, pageoff);
 }
 
+/*
+Increments the `U64` at the given data address. Clobbers only the scratch
+registers x16 and x17, which never hold inputs or locals; see `--profile`.
+*/
+static void asm_append_counter_inc(Comp *comp, Uint adr) {
+  asm_append_page_addr(comp, ASM_REG_VENEER, adr);
+  asm_append_load_scaled_offset(comp, ASM_REG_IP1, ASM_REG_VENEER, 0);
+  asm_append_add_imm(comp, ASM_REG_IP1, ASM_REG_IP1, 1);
+  asm_append_store_scaled_offset(comp, ASM_REG_IP1, ASM_REG_VENEER, 0);
+}
+
 static void asm_append_dysym_load(
   Comp *comp, const char *name, U8 reg, Comp_syms *syms
 ) {
@@ -1129,6 +1255,32 @@ static void asm_append_dysym_load(
   asm_append_page_load(comp, reg, (Uint)got_addr);
 }
 
+/*
+Calls an extern through its `Comp_heap.externs` entry. With `--opt`, the call
+is a `bl` to a per-word stub instead; see `asm_fixup_extern`. The register is
+used only without the stub.
+*/
+static void asm_append_call_dysym_extern(
+  Comp *comp, const Sym *callee, U8 reg
+) {
+  if (!comp->opt) {
+    asm_append_dysym_load(comp, callee->link_name, reg, &comp->code.externs);
+    asm_append_branch_link_to_reg(comp, reg);
+    return;
+  }
+
+  stack_push(
+    &comp->ctx.asm_fix,
+    (Asm_fixup){
+      .type = ASM_FIX_EXTERN,
+      .ext  = {
+        .callee = callee,
+        .instr  = asm_append_breakpoint(comp, ASM_CODE_EXTERN), // bl <stub>
+      },
+    }
+  );
+}
+
 static Err err_catch_no_throw(const char *callee) {
   return errf(
     "useless attempt to catch an error when calling word " FMT_QUOTED
@@ -1137,6 +1289,132 @@ static Err err_catch_no_throw(const char *callee) {
   );
 }
 
+/*
+Instruction decoding, used for relocating finalized code: when moving a word
+between instruction regions (`asm_relocate_instrs`), when inlining a word
+(`asm_inline_sym`), when compacting a word (`asm_peephole`), and when linking
+AOT executables (`./link.c`). Also used for finding loops when allocating
+locals (`asm_widen_live_ranges`). Covers only the PC-relative instructions
+we emit.
+*/
+
+// Page size implied by `adrp`, regardless of the OS page size.
+static constexpr Sint ASM_ADRP_PAGE = 1 << 12;
+
+static constexpr Instr ASM_MASK_BRANCH_IMM26 =
+  0b0'11111'00000000000000000000000000;
+static constexpr Instr ASM_BASE_BRANCH_IMM26 =
+  0b0'00101'00000000000000000000000000;
+static constexpr Instr ASM_MASK_BRANCH_LINK =
+  0b1'00000'00000000000000000000000000;
+static constexpr Instr ASM_MASK_ADR =
+  0b1'00'11111'0000000000000000000'00000;
+static constexpr Instr ASM_BASE_ADRP =
+  0b1'00'10000'0000000000000000000'00000;
+static constexpr Instr ASM_BASE_ADR =
+  0b0'00'10000'0000000000000000000'00000;
+static constexpr Instr ASM_MASK_BRANCH_COND =
+  0b11111111'0000000000000000000'1'0000;
+static constexpr Instr ASM_BASE_BRANCH_COND =
+  0b01010100'0000000000000000000'0'0000;
+static constexpr Instr ASM_MASK_COMPARE_BRANCH =
+  0b0'111111'0'0000000000000000000'00000;
+static constexpr Instr ASM_BASE_COMPARE_BRANCH =
+  0b0'011010'0'0000000000000000000'00000;
+static constexpr Instr ASM_BASE_TEST_BRANCH =
+  0b0'011011'0'0000000000000000000'00000;
+static constexpr Instr ASM_MASK_LDR_LIT =
+  0b00'111'0'11'0000000000000000000'00000;
+static constexpr Instr ASM_BASE_LDR_LIT =
+  0b00'011'0'00'0000000000000000000'00000;
+static constexpr Instr ASM_MASK_MOV_REG =
+  0b1'11'11111'11'1'00000'111111'11111'00000;
+static constexpr Instr ASM_BASE_MOV_REG =
+  0b1'01'01010'00'0'00000'000000'11111'00000;
+static constexpr Instr ASM_MASK_ADD_IMM =
+  0b1'1'1'111111'1'000000000000'00000'00000;
+static constexpr Instr ASM_BASE_ADD_IMM =
+  0b1'0'0'100010'0'000000000000'00000'00000;
+static constexpr Instr ASM_MASK_LDR_IMM =
+  0b11'111'1'11'11'000000000000'00000'00000;
+static constexpr Instr ASM_BASE_LDR_IMM =
+  0b11'111'0'01'01'000000000000'00000'00000;
+
+static U8 asm_decode_reg_0(Instr instr) { return (U8)(instr & 0b11111u); }
+
+static U8 asm_decode_reg_1(Instr instr) {
+  return (U8)((instr >> 5u) & 0b11111u);
+}
+
+// Sign-extends `imm26` in `b` / `bl`. The result is in instructions.
+static Sint asm_decode_branch_imm26(Instr instr) {
+  return (Sint)((S32)(instr << 6u) >> 6u);
+}
+
+// Sign-extends the page delta of `adrp`. See `asm_instr_adrp`.
+static Sint asm_decode_adrp_pages(Instr instr) {
+  const auto low  = (instr >> 29u) & 0b11u;
+  const auto high = (instr >> 5u) & 0b111'1111'1111'1111'1111u;
+  const auto imm  = (high << 2u) | low;
+  return (Sint)((S32)(imm << 11u) >> 11u);
+}
+
+/*
+Target page of `adrp` at the given instruction index, in bytes from the start
+of the instruction heap. Valid because the heap is page-aligned.
+*/
+static Sint asm_decode_adrp_page(Instr instr, Ind ind) {
+  const auto pc = (Sint)ind * (Sint)sizeof(Instr);
+  return (pc & ~(ASM_ADRP_PAGE - 1)) +
+    asm_decode_adrp_pages(instr) * ASM_ADRP_PAGE;
+}
+
+/*
+PC-relative offset, in instructions, of branches and loads with a short
+immediate: `b.cond`, `cbz`, `cbnz`, `tbz`, `tbnz`, and literal `ldr`.
+We only emit these within a word. Returns false for other instructions.
+*/
+static bool asm_decode_short_pc_off(Instr instr, Sint *out) {
+  if (
+    (instr & ASM_MASK_BRANCH_COND) == ASM_BASE_BRANCH_COND ||
+    (instr & ASM_MASK_COMPARE_BRANCH) == ASM_BASE_COMPARE_BRANCH ||
+    (instr & ASM_MASK_LDR_LIT) == ASM_BASE_LDR_LIT
+  ) {
+    *out = (Sint)((S32)(instr << 8u) >> 13u);
+    return true;
+  }
+
+  if ((instr & ASM_MASK_COMPARE_BRANCH) == ASM_BASE_TEST_BRANCH) {
+    *out = (Sint)((S32)(instr << 13u) >> 18u);
+    return true;
+  }
+  return false;
+}
+
+/*
+Target of `b`, `b.cond`, `cbz`, `cbnz`, `tbz`, or `tbnz` which branches
+backwards, which is how loops are compiled. Used for widening live ranges
+of locals; see `asm_widen_live_ranges`.
+*/
+static bool asm_decode_branch_back(Instr instr, Ind ind, Ind *out) {
+  Sint off;
+
+  if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+    if (instr & ASM_MASK_BRANCH_LINK) return false;
+    off = asm_decode_branch_imm26(instr);
+  }
+  else if ((instr & ASM_MASK_LDR_LIT) == ASM_BASE_LDR_LIT) {
+    return false;
+  }
+  else if (!asm_decode_short_pc_off(instr, &off)) {
+    return false;
+  }
+
+  if (off > 0 || -off > (Sint)ind) return false;
+  *out = (Ind)((Sint)ind + off);
+  return true;
+}
+
 #ifndef CALL_CONV_STACK
 #include "./arch_arm64_cc_reg.c" // IWYU pragma: export
 #else
@@ -1153,7 +1431,18 @@ static Err asm_append_call_norm(
   const auto pc_off = fun - comp_code_next_prog_counter(code);
 
   try_assert(comp_code_is_instr_ours(code, fun));
-  asm_append_branch_link_to_offset(comp, pc_off);
+
+  /*
+  `bl` reaches ±128 MiB, which is enough within one region of the code heap,
+  but not between regions. Longer calls go through a register instead.
+  */
+  if (pc_off >= -(1 << 25) && pc_off < (1 << 25)) {
+    asm_append_branch_link_to_offset(comp, pc_off);
+  }
+  else {
+    asm_append_page_addr(comp, ASM_REG_VENEER, (Uint)fun);
+    asm_append_branch_link_to_reg(comp, ASM_REG_VENEER);
+  }
 #ifdef CALL_CONV_STACK
   try(asm_append_try_catch(comp, caller, callee, err_mode));
 #else
@@ -1172,50 +1461,6 @@ static Err asm_append_call_norm(
   return nullptr;
 }
 
-// Simple, naive inlining without support for relocation.
-static Err asm_inline_sym(
-  Comp *comp, Sym *caller, const Sym *callee, bool err_mode
-) {
-  try(validate_sym_inlinable(callee));
-
-  const auto spans  = &callee->norm.spans;
-  const auto instrs = &comp->code.code_write;
-  const auto floor  = spans->prologue;
-  const auto ceil   = spans->ret;
-
-  for (Ind ind = floor; ind < ceil; ind++) {
-    stack_push(instrs, instrs->floor[ind]);
-  }
-
-#ifdef CALL_CONV_STACK
-  try(asm_append_try_catch(comp, caller, callee, err_mode));
-#else
-  (void)caller;
-  (void)err_mode;
-#endif
-
-  IF_DEBUG({
-    if (floor == ceil) {
-      eprintf(
-        "[system] skipped inlining " FMT_QUOTED ": zero useful instructions\n",
-        callee->name.buf
-      );
-    }
-    else {
-      eprintf(
-        "[system] inlined word " FMT_QUOTED "; instructions (" FMT_IND "):\n",
-        callee->name.buf,
-        ceil - floor
-      );
-      eprint_byte_range_hex(
-        (U8 *)&instrs->floor[floor], (U8 *)&instrs->floor[ceil]
-      );
-      fputc('\n', stderr);
-    }
-  });
-  return nullptr;
-}
-
 static void asm_fixup_throw(Comp *comp, const Asm_fixup *fix, const Sym *sym) {
   IF_DEBUG(assert_fatal(fix->type == ASM_FIX_THROW));
   IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
@@ -1229,6 +1474,84 @@ static void asm_fixup_throw(Comp *comp, const Asm_fixup *fix, const Sym *sym) {
   *instr = asm_instr_branch_to_offset(off);
 }
 
+/*
+Replaces a call in tail position with a branch to a stub appended after the
+epilogue, which tears down our frame and branches to the callee; the callee
+then returns directly to our caller. Self-recursion doesn't need a stub: it
+branches past the prologue, reusing the frame.
+
+Skipped in words with dynamic stack allocation, which may have passed
+pointers into their frame to the callee.
+*/
+static void asm_fixup_tail(Comp *comp, const Asm_fixup *fix, const Sym *sym) {
+  IF_DEBUG(assert_fatal(fix->type == ASM_FIX_TAIL));
+  IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
+  if (sym->norm.has_alloca) return;
+
+  const auto code   = &comp->code;
+  const auto write  = &code->code_write;
+  const auto instr  = fix->tail.instr;
+  const auto callee = fix->tail.callee;
+
+  if (callee == sym) {
+    const auto inner = &write->floor[sym->norm.spans.inner];
+    *instr           = asm_instr_branch_to_offset(inner - instr);
+    return;
+  }
+
+  *instr = asm_instr_branch_to_offset(write->top - instr);
+  asm_append_sym_frame_pop(comp, sym);
+
+  const auto fun    = comp_sym_exec_instr(comp, callee);
+  const auto pc_off = fun - comp_code_next_prog_counter(code);
+
+  // Same as in `asm_append_call_norm`.
+  if (pc_off >= -(1 << 25) && pc_off < (1 << 25)) {
+    asm_append_instr(comp, asm_instr_branch_to_offset(pc_off));
+  }
+  else {
+    asm_append_page_addr(comp, ASM_REG_VENEER, (Uint)fun);
+    asm_append_instr(comp, asm_instr_branch_to_reg(ASM_REG_VENEER));
+  }
+}
+
+/*
+Points an extern call at a stub appended after the epilogue, which loads the
+address from `Comp_heap.externs` and branches to it; this is what a PLT entry
+does in executable formats. Every call of the same extern in the word shares
+the stub, so call sites in loops are a single direct `bl`, and the page load
+is emitted once per word. Since the stub uses the same PC-relative idiom as
+inline calls, it works unchanged in AOT executables; see `./link.c`.
+
+We don't branch to the extern directly even when it's in range: that would
+only be valid in the JIT, while the same code is also used for AOT builds.
+*/
+static void asm_fixup_extern(Comp *comp, Asm_fixup *fix) {
+  IF_DEBUG(assert_fatal(fix->type == ASM_FIX_EXTERN));
+
+  const auto code   = &comp->code;
+  const auto instr  = fix->ext.instr;
+  const auto callee = fix->ext.callee;
+  Instr     *stub   = nullptr;
+
+  for (auto prev = comp->ctx.asm_fix.floor; prev < fix; prev++) {
+    if (prev->type != ASM_FIX_EXTERN || prev->ext.callee != callee) continue;
+    stub = prev->ext.stub;
+    break;
+  }
+
+  if (!stub) {
+    stub = code->code_write.top;
+    asm_append_dysym_load(
+      comp, callee->link_name, ASM_REG_VENEER, &code->externs
+    );
+    asm_append_instr(comp, asm_instr_branch_to_reg(ASM_REG_VENEER));
+  }
+
+  fix->ext.stub = stub;
+  *instr        = asm_instr_branch_link_to_offset(stub - instr);
+}
+
 static void asm_fixup(Comp *comp, Sym *sym) {
   for (stack_range(auto, fix, &comp->ctx.asm_fix)) {
     switch (fix->type) {
@@ -1248,6 +1571,14 @@ static void asm_fixup(Comp *comp, Sym *sym) {
         asm_fixup_recur(comp, fix, sym);
         continue;
       }
+      case ASM_FIX_TAIL: {
+        asm_fixup_tail(comp, fix, sym);
+        continue;
+      }
+      case ASM_FIX_EXTERN: {
+        asm_fixup_extern(comp, fix);
+        continue;
+      }
       default: unreachable();
     }
   }
@@ -1263,7 +1594,310 @@ static void asm_sym_beg(Comp *comp, Sym *sym) {
   spans->inner = stack_len_valid(instrs);
 }
 
-static void asm_sym_end(Comp *comp, Sym *sym) {
+// Inverse of `asm_decode_short_pc_off`.
+static Instr asm_encode_short_pc_off(Instr instr, Sint off) {
+  Instr imm;
+
+  if ((instr & ASM_MASK_COMPARE_BRANCH) == ASM_BASE_TEST_BRANCH) {
+    try_fatal(imm_signed(off, 14, &imm));
+    return (instr & ~((Instr)0x3FFF << 5u)) | (imm << 5u);
+  }
+
+  try_fatal(imm_signed(off, 19, &imm));
+  return (instr & ~((Instr)0x7FFFF << 5u)) | (imm << 5u);
+}
+
+/*
+Page offset from `add <reg>, <reg>, <pageoff>` or `ldr <_>, [<reg>, <pageoff>]`
+which follows `adrp <reg>`, as generated by `asm_append_page_addr` and
+`asm_append_page_load`. Returns false for any other instruction.
+*/
+static bool asm_decode_pageoff(Instr instr, U8 reg, Uint *out) {
+  if ((instr & ASM_MASK_ADD_IMM) == ASM_BASE_ADD_IMM) {
+    if (asm_decode_reg_0(instr) != reg || asm_decode_reg_1(instr) != reg) {
+      return false;
+    }
+    *out = (instr >> 10u) & 0b1111'1111'1111u;
+    return true;
+  }
+
+  if ((instr & ASM_MASK_LDR_IMM) == ASM_BASE_LDR_IMM) {
+    if (asm_decode_reg_1(instr) != reg) return false;
+    *out = ((instr >> 10u) & 0b1111'1111'1111u) * sizeof(U64);
+    return true;
+  }
+  return false;
+}
+
+/*
+Whether `ASM_COUNTER_INSTR_LEN` instructions at `instrs` were emitted by
+`asm_append_counter_inc`, for any counter address. Used for stripping the
+counters from AOT executables; see `./link.c`.
+*/
+static bool asm_is_counter_inc(const Instr *instrs) {
+  const auto adrp = instrs[0];
+  if ((adrp & ASM_MASK_ADR) != ASM_BASE_ADRP) return false;
+  if (asm_decode_reg_0(adrp) != ASM_REG_VENEER) return false;
+
+  const auto add = instrs[1];
+  if ((add & ASM_MASK_ADD_IMM) != ASM_BASE_ADD_IMM) return false;
+  if (asm_decode_reg_0(add) != ASM_REG_VENEER) return false;
+  if (asm_decode_reg_1(add) != ASM_REG_VENEER) return false;
+
+  return instrs[2] ==
+    asm_instr_load_scaled_offset(ASM_REG_IP1, ASM_REG_VENEER, 0) &&
+    instrs[3] == asm_instr_add_imm(ASM_REG_IP1, ASM_REG_IP1, 1) &&
+    instrs[4] == asm_instr_store_scaled_offset(ASM_REG_IP1, ASM_REG_VENEER, 0);
+}
+
+// Counterpart of `asm_decode_pageoff`.
+static Instr asm_encode_pageoff(Instr instr, Uint pageoff) {
+  if ((instr & ASM_MASK_ADD_IMM) == ASM_BASE_ADD_IMM) {
+    return asm_instr_add_imm(
+      asm_decode_reg_0(instr), asm_decode_reg_1(instr), pageoff
+    );
+  }
+  return asm_instr_load_scaled_offset(
+    asm_decode_reg_0(instr), asm_decode_reg_1(instr), pageoff
+  );
+}
+
+// Relocates one instruction at `ind` by `delta`; see `asm_relocate_instrs`.
+static Instr asm_relocate_instr(
+  Instr instr, Ind ind, Ind floor, Ind ceil, Sint delta
+) {
+  if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+    const auto off = asm_decode_branch_imm26(instr);
+    const auto tar = (Sint)ind + off;
+    if (tar >= (Sint)floor && tar < (Sint)ceil) return instr;
+
+    return (instr & ASM_MASK_BRANCH_LINK)
+      ? asm_instr_branch_link_to_offset(off - delta)
+      : asm_instr_branch_to_offset(off - delta);
+  }
+
+  if ((instr & ASM_MASK_ADR) == ASM_BASE_ADRP) {
+    const auto page = (Uint)asm_decode_adrp_page(instr, ind);
+    const auto pc   = (Uint)((Sint)ind + delta) * (Uint)sizeof(Instr);
+    return asm_instr_adrp(asm_decode_reg_0(instr), pc, page, nullptr);
+  }
+  return instr;
+}
+
+/*
+Whether `asm_relocate_instr` can move the instructions in `[floor, ceil)` by
+`delta`. Short PC-relative offsets must stay within `[floor, tar_ceil)`.
+`adr` may have been used to derive code-relative values, which we can't find,
+and short branches are never expected to leave a word.
+*/
+static bool asm_is_relocatable(
+  const Instr *instrs, Ind floor, Ind ceil, Ind tar_ceil, Sint delta
+) {
+  for (Ind ind = floor; ind < ceil; ind++) {
+    const auto instr = instrs[ind];
+    if ((instr & ASM_MASK_ADR) == ASM_BASE_ADR) return false;
+
+    if ((instr & ASM_MASK_ADR) == ASM_BASE_ADRP) {
+      if (asm_decode_adrp_page(instr, ind) < 0) return false;
+      continue;
+    }
+
+    // The adjusted offset must remain encodable.
+    if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+      const auto tar = (Sint)ind + asm_decode_branch_imm26(instr);
+      if (tar >= (Sint)floor && tar < (Sint)tar_ceil) continue;
+
+      const auto off = asm_decode_branch_imm26(instr) - delta;
+      if (off < -(1 << 25) || off >= (1 << 25)) return false;
+      continue;
+    }
+
+    Sint off;
+    if (!asm_decode_short_pc_off(instr, &off)) continue;
+
+    const auto tar = (Sint)ind + off;
+    if (tar < (Sint)floor || tar >= (Sint)tar_ceil) return false;
+  }
+  return true;
+}
+
+/*
+Moves the finalized instructions of a word, in `[spans.floor, ceil)` of the
+writable heap, to `new_floor`, re-patching instructions whose PC-relative
+targets are outside of the range: `b` / `bl` into other words and `adrp` of
+other sections. Local immediate values, from `spans.data`, are copied as-is.
+Used when moving a word between instruction regions; see `comp_sym_settle`.
+
+Returns false without moving anything if the word can't be relocated;
+see `asm_is_relocatable`.
+*/
+static bool asm_relocate_instrs(
+  Comp_code *code, const Sym_instrs *spans, Ind ceil, Ind new_floor
+) {
+  const auto instrs = code->code_write.floor;
+  const auto floor  = spans->floor;
+  const auto data   = spans->data;
+  const auto delta  = (Sint)new_floor - (Sint)floor;
+
+  if (!asm_is_relocatable(instrs, floor, data, ceil, delta)) return false;
+
+  for (Ind ind = floor; ind < ceil; ind++) {
+    const auto instr   = instrs[ind];
+    const auto new_ind = (Ind)((Sint)ind + delta);
+
+    instrs[new_ind] = ind < data
+      ? asm_relocate_instr(instr, ind, floor, ceil, delta)
+      : instr;
+  }
+  return true;
+}
+
+/*
+Whether the `nop` at `instr` was left by an unconfirmed local relocation
+(see `asm_fixup_locals`). Other nops, such as ones emitted by Forth code
+or copied from inlined words, may be there on purpose, and are kept.
+*/
+static bool asm_peephole_reloc_nop(Comp *comp, const Instr *instr) {
+#ifdef CALL_CONV_STACK
+  (void)comp;
+  (void)instr;
+  return false;
+#else
+  for (stack_range(auto, fix, &comp->ctx.loc_fix)) {
+    if (fix->type != LOC_FIX_RELOC) continue;
+    if (fix->reloc.instr == instr) return !fix->reloc.confirmed;
+  }
+  return false;
+#endif
+}
+
+/*
+Instructions which `asm_peephole` drops from `[spans.floor, spans.ret)`:
+unused slots reserved for the prologue, `nop` from unconfirmed local
+relocations, and `mov` of a register to itself.
+*/
+static bool asm_peephole_removable(
+  Comp *comp, const Instr *instr, Ind ind, const Sym_instrs *spans
+) {
+  if (ind < spans->prologue) return true;
+  if (ind >= spans->ret) return false;
+  if (*instr == ASM_INSTR_NOP) return asm_peephole_reloc_nop(comp, instr);
+
+  return (*instr & ASM_MASK_MOV_REG) == ASM_BASE_MOV_REG &&
+    asm_decode_reg_0(*instr) == ((*instr >> 16u) & 0b11111u);
+}
+
+/*
+Re-encodes one kept instruction moved from `ind` to `new_ind` by `asm_peephole`.
+`map` gives the new index of each instruction in `[floor, ceil]`.
+*/
+static Instr asm_peephole_instr(
+  Instr instr, Ind ind, Ind new_ind, Ind floor, Ind ceil, const Ind *map
+) {
+  const auto delta = (Sint)new_ind - (Sint)ind;
+
+  if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+    const auto tar = (Sint)ind + asm_decode_branch_imm26(instr);
+    if (tar < (Sint)floor || tar > (Sint)ceil) {
+      return asm_relocate_instr(instr, ind, floor, ceil + 1, delta);
+    }
+
+    const auto off = (Sint)map[tar - (Sint)floor] - (Sint)new_ind;
+    return (instr & ASM_MASK_BRANCH_LINK)
+      ? asm_instr_branch_link_to_offset(off)
+      : asm_instr_branch_to_offset(off);
+  }
+
+  Sint off;
+  if (asm_decode_short_pc_off(instr, &off)) {
+    const auto tar = (Sint)ind + off;
+    return asm_encode_short_pc_off(
+      instr, (Sint)map[tar - (Sint)floor] - (Sint)new_ind
+    );
+  }
+  return asm_relocate_instr(instr, ind, floor, ceil + 1, delta);
+}
+
+/*
+Optional pass over a just-finalized word, enabled by `--opt`. Drops the
+instructions described in `asm_peephole_removable`, moving the rest down,
+then re-encodes PC-relative instructions for their new positions and remaps
+the spans. By then, all `Asm_fixup` have been applied, and their targets are
+ordinary branches, which are remapped like the others.
+
+Skipped when the word's address may have been observed (`Comp_ctx.pinned`),
+and when we can't tell how to re-encode something; see `asm_is_relocatable`.
+*/
+static void asm_peephole(Comp *comp, Sym *sym) {
+  if (comp->ctx.pinned) return;
+
+  const auto write  = &comp->code.code_write;
+  const auto instrs = write->floor;
+  const auto spans  = &sym->norm.spans;
+  const auto floor  = spans->floor;
+  const auto data   = spans->data;
+  const auto ceil   = spans->ceil;
+
+  deferred(list_deinit) Ind_list map = {};
+  list_reserve_total_cap(&map, ceil - floor + 1);
+
+  Ind next = floor;
+
+  for (Ind ind = floor; ind < ceil; ind++) {
+    const auto instr = instrs[ind];
+    list_append(&map, next);
+
+    if (ind < data) {
+      if ((instr & ASM_MASK_ADR) == ASM_BASE_ADR) return;
+
+      // Offsets into other words must remain encodable.
+      if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+        const auto tar = (Sint)ind + asm_decode_branch_imm26(instr);
+        const auto off = tar - (Sint)next;
+        if (off < -(1 << 25) || off >= (1 << 25)) return;
+      }
+
+      Sint off;
+      if (asm_decode_short_pc_off(instr, &off)) {
+        const auto tar = (Sint)ind + off;
+        if (tar < (Sint)floor || tar > (Sint)ceil) return;
+      }
+    }
+
+    if (!asm_peephole_removable(comp, &instrs[ind], ind, spans)) next++;
+  }
+  list_append(&map, next);
+
+  if (next == ceil) return;
+
+  for (Ind ind = floor; ind < ceil; ind++) {
+    const auto new_ind = map.dat[ind - floor];
+    if (new_ind == map.dat[ind - floor + 1]) continue;
+
+    const auto instr = instrs[ind];
+    instrs[new_ind]  = ind < data
+      ? asm_peephole_instr(instr, ind, new_ind, floor, ceil, map.dat)
+      : instr;
+  }
+
+  spans->prologue = map.dat[spans->prologue - floor];
+  spans->inner    = map.dat[spans->inner - floor];
+  spans->epi_ok   = map.dat[spans->epi_ok - floor];
+  spans->epi_err  = map.dat[spans->epi_err - floor];
+  spans->ret      = map.dat[spans->ret - floor];
+  spans->data     = map.dat[data - floor];
+  spans->ceil     = next;
+  stack_trunc_to(write, next);
+
+  IF_DEBUG(eprintf(
+    "[system] peephole: dropped " FMT_IND " instructions from word " FMT_QUOTED
+    "\n",
+    ceil - next,
+    sym->name.buf
+  ));
+}
+
+static Err asm_sym_end(Comp *comp, Sym *sym) {
   const auto code  = &comp->code;
   const auto write = &code->code_write;
   const auto spans = &sym->norm.spans;
@@ -1284,13 +1918,85 @@ static void asm_sym_end(Comp *comp, Sym *sym) {
   spans->ret = stack_len_valid(write);
   asm_append_instr(comp, ASM_INSTR_RET);
 
-  spans->data = stack_len_valid(write);
+  // May append tail-call and extern stubs.
   asm_fixup(comp, sym);
+  spans->data = stack_len_valid(write);
 
-  // Execution never reaches this. Makes it easier to tell functions apart.
   spans->ceil = stack_len_valid(write);
+  if (comp->opt) asm_peephole(comp, sym);
+
+  // Execution never reaches this. Makes it easier to tell functions apart.
   IF_DEBUG(asm_append_breakpoint(comp, ASM_CODE_PROC_DELIM));
 
   code->valid_instr_len = stack_len_valid(write);
   sym->norm.exec        = asm_sym_prologue_executable(comp, sym);
+  return nullptr;
+}
+
+/*
+Whether `asm_inline_sym` can copy the word, regardless of the destination.
+Used to decide automatic inlining; see `sym_auto_inlinable`.
+*/
+static bool asm_sym_inline_relocatable(const Comp_code *code, const Sym *sym) {
+  const auto spans = &sym->norm.spans;
+  return asm_is_relocatable(
+    code->code_write.floor, spans->prologue, spans->ret, spans->ret + 1, 0
+  );
+}
+
+/*
+Copies the inner code of a leaf word to the current position. Instructions
+which reference other sections, such as `adrp` of data or externs, are
+re-encoded for the new position; see `asm_relocate_instr`.
+*/
+static Err asm_inline_sym(
+  Comp *comp, Sym *caller, const Sym *callee, bool err_mode
+) {
+  try(validate_sym_inlinable(callee));
+
+  const auto spans  = &callee->norm.spans;
+  const auto instrs = &comp->code.code_write;
+  const auto floor  = spans->prologue;
+  const auto ceil   = spans->ret;
+  const auto delta  = (Sint)stack_len_valid(instrs) - (Sint)floor;
+
+  // Branches to `ret` land right after the inlined code.
+  if (!asm_is_relocatable(instrs->floor, floor, ceil, ceil + 1, delta)) {
+    return err_inline_pc_rel(callee);
+  }
+
+  for (Ind ind = floor; ind < ceil; ind++) {
+    const auto instr = instrs->floor[ind];
+    asm_append_instr(
+      comp, asm_relocate_instr(instr, ind, floor, ceil + 1, delta)
+    );
+  }
+
+#ifdef CALL_CONV_STACK
+  try(asm_append_try_catch(comp, caller, callee, err_mode));
+#else
+  (void)caller;
+  (void)err_mode;
+#endif
+
+  IF_DEBUG({
+    if (floor == ceil) {
+      eprintf(
+        "[system] skipped inlining " FMT_QUOTED ": zero useful instructions\n",
+        callee->name.buf
+      );
+    }
+    else {
+      eprintf(
+        "[system] inlined word " FMT_QUOTED "; instructions (" FMT_IND "):\n",
+        callee->name.buf,
+        ceil - floor
+      );
+      eprint_byte_range_hex(
+        (U8 *)&instrs->floor[floor], (U8 *)&instrs->floor[ceil]
+      );
+      fputc('\n', stderr);
+    }
+  });
+  return nullptr;
 }
@@ -37,6 +37,19 @@ Using this on functions with fewer actual inputs or outputs is harmless.
 */
 typedef Sint(Extern_fun)(Sint, Sint, Sint, Sint, Sint, Sint, Sint, Sint);
 
+/*
+Variants for externs with `F64` parameters, which are passed in d0 … d7,
+numbered independently from GPR parameters. See `asm_call_extern_float`.
+*/
+typedef Sint(Extern_fun_flt_inp)(
+  Sint, Sint, Sint, Sint, Sint, Sint, Sint, Sint,
+  F64, F64, F64, F64, F64, F64, F64, F64
+);
+typedef F64(Extern_fun_flt_out)(
+  Sint, Sint, Sint, Sint, Sint, Sint, Sint, Sint,
+  F64, F64, F64, F64, F64, F64, F64, F64
+);
+
 /*
 In instruction encoding, registers 0-31 are represented with corresponding
 5-bit unsigned integers. This applies to GPRs and vector/float registers.
@@ -75,7 +88,9 @@ static constexpr U8 ASM_SCRATCH_REG_14 = 14;
 static constexpr U8 ASM_SCRATCH_REG_15 = 15;
 
 /*
-Registers x16 x17 are reserved for debuggers; x18 is reserved for the OS.
+Registers x16 x17 are intra-procedure-call scratch registers, which may be
+clobbered by linker veneers; we use x16 for our own long calls, see below.
+x18 is reserved for the OS.
 MacOS uses x18 for syscall numbers. x19 … x28 are callee-saved registers,
 which must be stashed and restored when used by a callee. We also reserve
 some of these for special roles; see below.
@@ -92,6 +107,12 @@ static constexpr U8 ASM_STABLE_REG_27    = 27;
 static constexpr U8 ASM_STABLE_REG_28    = 28;
 static constexpr U8 ASM_STABLE_REG_FIRST = ASM_STABLE_REG_19;
 
+// Holds the target of a call which doesn't fit into `bl`.
+static constexpr U8 ASM_REG_VENEER = 16;
+
+// Second intra-procedure-call scratch; used for `--profile` call counters.
+static constexpr U8 ASM_REG_IP1 = 17;
+
 // Frame pointer register; holds address of `{x29, x30}`.
 static constexpr U8 ASM_REG_FP = 29;
 
@@ -101,9 +122,15 @@ static constexpr U8 ASM_REG_LINK = 30;
 // System stack pointer; also treated as a null register by many instructions.
 static constexpr U8 ASM_REG_SP = 31;
 
+// Register 31 read as `xzr` by `orr`, which `asm_instr_mov_reg` encodes.
+static constexpr U8 ASM_REG_ZERO = 31;
+
 // Extremely primitive heuristic. 4 seems enough.
 static constexpr U8 ASM_INLINABLE_INSTR_LEN = 4;
 
+// `adrp`, `add`, `ldr`, `add`, `str`; see `asm_append_counter_inc`.
+static constexpr U8 ASM_COUNTER_INSTR_LEN = 5;
+
 // SYNC[asm_reg_ctx].
 static constexpr U8 ASM_REG_CTX = 28;
 
@@ -132,6 +159,26 @@ static constexpr U8 ASM_STABLE_REG_LEN = ASM_STABLE_REG_LAST - ASM_STABLE_REG_FI
 
 // clang-format on
 
+/*
+Vector registers v0 … v31 are handed out by `comp_alloc_vec_reg`.
+Their clobbers are tracked in the upper half of `Sym.clobber`,
+starting at `ASM_VEC_CLOBBER_SHIFT`; GPRs only use the lower half.
+
+- v0 … v7 pass `F64` params to externs; never allocated.
+- v8 … v15 are callee-saved, but only in their low 64 bits. We save them
+  whole, so they survive calls to Forth words, but not to foreign code.
+- v16 … v31 are scratch.
+*/
+static constexpr U8   ASM_VEC_REG_LEN          = 32;
+static constexpr U8   ASM_VEC_CLOBBER_SHIFT    = 32;
+static constexpr U8   ASM_VEC_STABLE_REG_FIRST = 8;
+static constexpr U8   ASM_VEC_STABLE_REG_LEN   = 8;
+static constexpr Bits ASM_VEC_REGS_STABLE      = 0b11111111'00000000;
+static constexpr Bits ASM_VEC_REGS_SCRATCH     = 0xFFFF'0000;
+static constexpr Bits ASM_VEC_REGS_ALL         = 0xFFFF'FFFF;
+
+static_assert(ASM_REG_LEN <= ASM_VEC_CLOBBER_SHIFT);
+
 // Magic numbers for `brk` instructions. Makes them more identifiable.
 typedef enum : Instr {
   ASM_CODE_RET = 1,
@@ -142,6 +189,7 @@ typedef enum : Instr {
   ASM_CODE_LOC_READ,
   ASM_CODE_LOC_RELOC,
   ASM_CODE_PROC_DELIM,
+  ASM_CODE_EXTERN,
 } Asm_magic;
 
 static constexpr U8 ASM_FRAME_RECORD_SIZE = 16;
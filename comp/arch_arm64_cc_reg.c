@@ -352,14 +352,39 @@ static Err asm_append_call_intrin(Comp *comp, Sym *caller, const Sym *callee) {
   return nullptr;
 }
 
+/*
+Externs declared via `.extern_float` take `F64` inputs in d0 … d7, numbered
+independently from GPR inputs. Our inputs are in x0 … xN in their declared
+order; floats are moved into FP registers, and the remaining inputs shifted
+down. Each GPR is read before being overwritten, since a target index never
+exceeds its source index.
+*/
+static void asm_append_extern_float_inps(Comp *comp, const Sym *callee) {
+  U8 gpr = 0;
+  U8 fpr = 0;
+
+  for (U8 reg = 0; reg < callee->inp_len; reg++) {
+    if ((callee->flt_inps >> reg) & 1u) {
+      asm_append_fmov_to_fp(comp, fpr++, reg);
+      continue;
+    }
+    if (gpr != reg) asm_append_mov_reg(comp, gpr, reg);
+    gpr++;
+  }
+}
+
 static void asm_append_call_extern(Comp *comp, const Sym *callee) {
   assert_fatal(callee->type == SYM_EXTERN);
 
+  if (callee->flt_inps) asm_append_extern_float_inps(comp, callee);
+
   // Free to use because extern calls clobber everything anyway.
   constexpr auto reg = ASM_SCRATCH_REG_8;
+  asm_append_call_dysym_extern(comp, callee, reg);
 
-  asm_append_dysym_load(comp, callee->link_name, reg, &comp->code.externs);
-  asm_append_branch_link_to_reg(comp, reg);
+  if (callee->flt_out && callee->out_len) {
+    asm_append_fmov_from_fp(comp, ASM_PARAM_REG_0, 0);
+  }
 }
 
 /*
@@ -409,34 +434,52 @@ static Instr asm_instr_local_write(Local *loc, U8 src_reg) {
   }
 }
 
+// Whether no other local in `reg` is live anywhere in the range of `loc`.
+static bool asm_local_reg_free(const Comp_ctx *ctx, const Local *loc, U8 reg) {
+  for (stack_range(auto, other, &ctx->locals)) {
+    if (other == loc) continue;
+    if (other->location != LOC_REG || other->reg != reg) continue;
+    if (other->live_floor >= loc->live_ceil) continue;
+    if (loc->live_floor >= other->live_ceil) continue;
+    return false;
+  }
+  return true;
+}
+
 /*
 We accumulate clobbers of volatile registers from ALL sources across the entire
 function, and always treat these registers as temporary, meaning that no locals
 across the function would be assigned to these locations, even for locals whose
 lifetimes do not overlap with clobbers. Simple way of avoiding an additional IR
 and data flow analysis.
+
+Registers which are left over for locals are allocated by live range: a local
+takes the lowest register not held by another local whose range overlaps. Since
+fixups are resolved in instruction order, this is a linear scan. Callee-saved
+registers remain contiguous from `ASM_STABLE_REG_FIRST`, as the prologue
+expects; see `asm_fixup_sym_prologue`.
 */
 static void asm_resolve_local_location(Comp *comp, Local *loc, Sym *sym) {
   if (loc->location != LOC_UNKNOWN) return;
 
   const auto ctx = &comp->ctx;
+  auto       vol = ctx->vol_regs;
 
-  if (ctx->vol_regs) {
-    const auto reg = bits_pop_low(&ctx->vol_regs);
+  while (vol) {
+    const auto reg = bits_pop_low(&vol);
+    if (!bits_has(ASM_REGS_VOLATILE, reg)) continue;
+    if (!asm_local_reg_free(ctx, loc, reg)) continue;
 
-    if (bits_has(ASM_REGS_VOLATILE, reg)) {
-      loc->location = LOC_REG;
-      loc->reg      = reg;
-      bits_add_to(&sym->clobber, reg);
-      return;
-    }
+    loc->location = LOC_REG;
+    loc->reg      = reg;
+    bits_add_to(&sym->clobber, reg);
+    return;
   }
 
   // Can we assign a callee-saved register?
-  if (ctx->saved_reg < ASM_STABLE_REG_LAST) {
-    U8 reg;
-    if (ctx->saved_reg) reg = ++ctx->saved_reg;
-    else reg = (ctx->saved_reg = ASM_STABLE_REG_FIRST);
+  for (U8 reg = ASM_STABLE_REG_FIRST; reg <= ASM_STABLE_REG_LAST; reg++) {
+    if (!asm_local_reg_free(ctx, loc, reg)) continue;
+    if (reg > ctx->saved_reg) ctx->saved_reg = reg;
 
     loc->location = LOC_REG;
     loc->reg      = reg;
@@ -495,6 +538,80 @@ static Bits asm_remaining_vol_regs(const Sym *sym) {
   return regs;
 }
 
+static void asm_local_live_add(Local *loc, Ind ind) {
+  if (!loc->live_ceil) {
+    loc->live_floor = ind;
+    loc->live_ceil  = ind + 1;
+    return;
+  }
+  if (ind < loc->live_floor) loc->live_floor = ind;
+  if (ind >= loc->live_ceil) loc->live_ceil = ind + 1;
+}
+
+/*
+A loop is compiled as a backward branch. A local which is accessed anywhere in
+a loop may be live across its back edge, so its range must cover the whole
+loop. Widening a range may make it overlap another loop, so we repeat until
+nothing changes. Conservative, but needs no control flow graph.
+*/
+static void asm_widen_live_ranges(Comp *comp, const Sym *sym) {
+  const auto ctx     = &comp->ctx;
+  const auto write   = &comp->code.code_write;
+  const auto floor   = sym->norm.spans.inner;
+  const auto ceil    = stack_len_valid(write);
+  bool       widened = true;
+
+  while (widened) {
+    widened = false;
+
+    for (Ind ind = floor; ind < ceil; ind++) {
+      Ind tar;
+      if (!asm_decode_branch_back(write->floor[ind], ind, &tar)) continue;
+      if (tar < floor) continue;
+
+      for (stack_range(auto, loc, &ctx->locals)) {
+        if (!loc->live_ceil) continue;
+        if (loc->live_floor > ind || loc->live_ceil <= tar) continue;
+
+        if (loc->live_floor > tar) {
+          loc->live_floor = tar;
+          widened         = true;
+        }
+        if (loc->live_ceil <= ind) {
+          loc->live_ceil = ind + 1;
+          widened        = true;
+        }
+      }
+    }
+  }
+}
+
+/*
+Live range of each local's stable location: from the first to the last of its
+reads and confirmed relocs. Unconfirmed relocs become nops and don't count.
+*/
+static void asm_compute_live_ranges(Comp *comp, const Sym *sym) {
+  const auto ctx    = &comp->ctx;
+  const auto instrs = comp->code.code_write.floor;
+
+  for (stack_range(auto, fix, &ctx->loc_fix)) {
+    switch (fix->type) {
+      case LOC_FIX_READ: {
+        asm_local_live_add(fix->read.loc, (Ind)(fix->read.instr - instrs));
+        continue;
+      }
+      case LOC_FIX_RELOC: {
+        if (!fix->reloc.confirmed) continue;
+        asm_local_live_add(fix->reloc.loc, (Ind)(fix->reloc.instr - instrs));
+        continue;
+      }
+      default: unreachable();
+    }
+  }
+
+  asm_widen_live_ranges(comp, sym);
+}
+
 static void asm_fixup_locals(Comp *comp, Sym *sym) {
   const auto ctx = &comp->ctx;
 
@@ -503,6 +620,7 @@ static void asm_fixup_locals(Comp *comp, Sym *sym) {
   ctx->vol_regs = asm_remaining_vol_regs(sym);
 
   assert_fatal(!ctx->saved_reg);
+  asm_compute_live_ranges(comp, sym);
 
   for (stack_range(auto, fix, &ctx->loc_fix)) {
     switch (fix->type) {
@@ -189,9 +189,7 @@ static void asm_append_call_extern(Comp *comp, const Sym *callee) {
   if (inp_len > 0) asm_append_stack_pop_into(comp, ASM_PARAM_REG_0);
 
   constexpr auto reg = ASM_SCRATCH_REG_8;
-
-  asm_append_dysym_load(comp, callee->link_name, reg, &comp->code.externs);
-  asm_append_branch_link_to_reg(comp, reg);
+  asm_append_call_dysym_extern(comp, callee, reg);
   if (out_len) asm_append_stack_push_from(comp, ASM_REG_ERR);
 
   /*
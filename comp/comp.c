@@ -61,6 +61,10 @@ static Local *comp_local_get(Comp *comp, const char *name) {
   return dict_get(&comp->ctx.local_dict, name);
 }
 
+static Local *comp_local_get_key(Comp *comp, Dict_key key) {
+  return dict_get_key(&comp->ctx.local_dict, key);
+}
+
 static Err comp_local_get_or_make(Comp *comp, Word_str name, Local **out) {
 #ifndef CALL_CONV_STACK
   try(comp_validate_local_name(name));
@@ -129,6 +133,7 @@ static bool comp_code_valid(const Comp_code *code) {
     is_aligned(&code->externs) &&
     is_aligned(&code->intrins) &&
     is_aligned(&code->valid_instr_len) &&
+    is_aligned(&code->exec_write) &&
     instr_heap_valid(code->write) &&
     comp_heap_valid(code->heap) &&
     span_valid((const Span *)&code->code_write) &&
@@ -158,15 +163,15 @@ static Err instr_heap_deinit(Instr_heap **out) {
   return err;
 }
 
+// Instructions are committed on demand; see `comp_code_commit`.
 static Err instr_heap_init(Instr_heap **out) {
   *out = nullptr;
 
   const auto ptr = mem_map(sizeof(Instr_heap), 0);
   if (ptr == MAP_FAILED) return err_mmap();
 
-  const auto base = (Instr_heap *)ptr;
-  *out            = base;
-  return mem_protect(base->instrs, sizeof(base->instrs), PROT_READ | PROT_WRITE);
+  *out = (Instr_heap *)ptr;
+  return nullptr;
 }
 
 static Err comp_heap_deinit(Comp_heap **out) {
@@ -176,16 +181,16 @@ static Err comp_heap_deinit(Comp_heap **out) {
   return err;
 }
 
-static Err comp_heap_init(Comp_heap **out) {
+// When `addr` is non-null, the heap must be placed exactly at that address.
+static Err comp_heap_init(Comp_heap **out, void *addr) {
   *out = nullptr;
 
   void *ptr;
-  try(mem_map_jit(sizeof(Comp_heap), &ptr));
+  try(mem_map_jit(addr, sizeof(Comp_heap), &ptr));
 
   const auto heap = (Comp_heap *)ptr;
   *out            = heap;
 
-  try(mprotect_jit(heap->exec.instrs, sizeof(heap->exec.instrs)));
   try(mem_protect(heap->data, sizeof(heap->data), PROT_READ | PROT_WRITE));
   try(mem_protect(heap->externs, sizeof(heap->externs), PROT_READ | PROT_WRITE));
   try(mem_protect(heap->intrins, sizeof(heap->intrins), PROT_READ | PROT_WRITE));
@@ -199,21 +204,29 @@ static Err comp_code_deinit(Comp_code *code) {
   dict_deinit(&code->intrins.inds);
 
   Err err = nullptr;
+  if (code->heap) {
+    const auto exec = &code->heap->exec;
+    err             = jit_code_deinit(
+      exec->instrs, code->exec_write, sizeof(exec->instrs)
+    );
+  }
   err     = either(err, stack_deinit(&code->externs.names));
   err     = either(err, stack_deinit(&code->intrins.names));
+  err     = either(err, stack_deinit(&code->data_allocs));
   err     = either(err, instr_heap_deinit(&code->write));
   err     = either(err, comp_heap_deinit(&code->heap));
   *code   = (Comp_code){};
   return err;
 }
 
+// Starts in the runtime region; see `comp_code_select_region`.
 static void comp_code_init_spans(Comp_code *code) {
   ptr_set(
     &code->code_write,
     {
       .floor = code->write->instrs,
       .top   = code->write->instrs,
-      .ceil  = arr_ceil(code->write->instrs),
+      .ceil  = code->write->instrs + INSTR_RUNTIME_LEN,
     }
   );
 
@@ -222,10 +235,19 @@ static void comp_code_init_spans(Comp_code *code) {
     {
       .floor = code->heap->exec.instrs,
       .top   = code->heap->exec.instrs,
-      .ceil  = arr_ceil(code->heap->exec.instrs),
+      .ceil  = code->heap->exec.instrs + INSTR_RUNTIME_LEN,
     }
   );
 
+  code->region       = INSTR_REGION_RUNTIME;
+  code->instr_commit = 0;
+  code->inactive     = (Instr_region_lens){
+    .write  = INSTR_RUNTIME_LEN,
+    .exec   = INSTR_RUNTIME_LEN,
+    .valid  = INSTR_RUNTIME_LEN,
+    .commit = INSTR_RUNTIME_LEN,
+  };
+
   ptr_set(
     &code->data,
     {
@@ -254,11 +276,17 @@ static void comp_code_init_spans(Comp_code *code) {
   );
 }
 
-static Err comp_code_init(Comp_code *code) {
+static Err comp_code_init(Comp_code *code, void *heap_addr) {
   *code = (Comp_code){};
 
   try(instr_heap_init(&code->write));
-  try(comp_heap_init(&code->heap));
+  try(comp_heap_init(&code->heap, heap_addr));
+
+  const auto exec = &code->heap->exec;
+  void      *write;
+  try(jit_code_init(exec->instrs, sizeof(exec->instrs), &write));
+  code->exec_write = write;
+
   comp_code_init_spans(code);
 
   auto opt = (Stack_opt){.len = arr_cap(code->heap->externs)};
@@ -267,17 +295,23 @@ static Err comp_code_init(Comp_code *code) {
   opt = (Stack_opt){.len = arr_cap(code->heap->intrins)};
   try(stack_init(&code->intrins.names, &opt));
 
+  opt = (Stack_opt){.len = DATA_ALLOCS_LEN};
+  try(stack_init(&code->data_allocs, &opt));
+
   return nullptr;
 }
 
-static Err comp_init(Comp *comp) {
+// See `comp_heap_init` for `heap_addr`.
+static Err comp_init(Comp *comp, void *heap_addr) {
   *comp = (Comp){};
-  try(comp_code_init(&comp->code));
+  try(comp_code_init(&comp->code, heap_addr));
   try(comp_ctx_init(&comp->ctx));
   return nullptr;
 }
 
 static Err comp_deinit(Comp *comp) {
+  list_deinit(&comp->prof);
+
   Err err = nullptr;
   err     = either(err, comp_ctx_deinit(&comp->ctx));
   err     = either(err, comp_code_deinit(&comp->code));
@@ -364,16 +398,129 @@ static Err comp_append_call_sym(Comp *comp, Sym *callee) {
   return nullptr;
 }
 
-static void comp_sym_beg(Comp *comp, Sym *sym) {
+// See `INSTR_RUNTIME_LEN`.
+static Instr_region comp_sym_region(const Sym *sym) {
+  const auto comptime =
+    sym->wordlist == WORDLIST_COMP || sym->comp_only || sym->interp_only;
+  return comptime ? INSTR_REGION_COMP : INSTR_REGION_RUNTIME;
+}
+
+static Err err_out_of_space_data() {
+  return err_str("unable to allocate static data: out of space");
+}
+
+// The resulting address is located at a significant distance from executable
+// code, and needs to be accessed via the `adrp & add/ldr` idiom.
+static Err comp_alloc_data(Comp *comp, Ind size, Ind align, const U8 **out) {
+  const auto code   = &comp->code;
+  const auto data   = &code->data;
+  const auto allocs = &code->data_allocs;
+  const auto len    = __builtin_align_up(stack_len_valid(data), align);
+  const auto cap    = stack_cap_valid(data);
+
+  if (len > cap || size > cap - len) return err_out_of_space_data();
+  if (stack_rem(allocs) <= 0) return err_out_of_space_data();
+
+  data->top      = data->floor + len;
+  const auto adr = data->top;
+  data->top += size;
+
+  stack_push(allocs, (Data_alloc){.off = len, .len = size, .align = align});
+
+  if (out) *out = adr;
+
+  IF_DEBUG(eprintf(
+    "[system] allocated data region with address %p and length " FMT_IND "\n",
+    adr,
+    size
+  ));
+  return nullptr;
+}
+
+/*
+Used with `--profile`. Allocates a call counter in the data region, and emits
+code at the start of the body which increments it on every call of the word,
+including self-recursive tail calls, which branch past the prologue. The AOT
+linker uses the counts to order words by hotness; see `link_order_syms`, and
+strips the counters from shaken executables; see `link_collect_counters`.
+
+A word's own counter doesn't count towards the auto-inlining limit; see
+`comp_sym_end`. Inlined copies keep incrementing the callee's counter, and
+do count towards the caller's length, so a word which itself inlines words
+may be too long to auto-inline only when profiling.
+*/
+static Err comp_profile_sym(Comp *comp, Sym *sym) {
+  const U8 *adr;
+  try(comp_alloc_data(comp, sizeof(U64), alignof(U64), &adr));
+
+  const auto off = (Ind)(adr - comp->code.data.floor);
+  list_append(&comp->prof, (Prof_counter){.sym = sym, .off = off});
+  asm_append_counter_inc(comp, (Uint)adr);
+  return nullptr;
+}
+
+static Err comp_sym_beg(Comp *comp, Sym *sym) {
   comp_ctx_trunc(&comp->ctx);
+  comp_code_select_region(&comp->code, comp_sym_region(sym));
+  try(comp_code_ensure_space(&comp->code));
+
   comp->ctx.sym       = sym;
   comp->ctx.compiling = true;
   asm_sym_beg(comp, sym);
+  if (comp->profile) try(comp_profile_sym(comp, sym));
+  return nullptr;
+}
+
+/*
+At the start of a definition, we usually don't know yet whether the word is
+`comp_only` or `interp_only`: the flags are set by its body, or inherited from
+its callees. A word which turns out to be comptime-only is moved from the end
+of the runtime region to the comptime region. Nothing else references its code
+yet, unless its address was stashed via `.here_exec`; see `Comp_ctx.pinned`.
+Moving is best-effort: when unsupported, the word stays in the runtime region.
+*/
+static void comp_sym_settle(Comp *comp, Sym *sym) {
+  const auto code = &comp->code;
+  if (code->region != INSTR_REGION_RUNTIME) return;
+  if (comp_sym_region(sym) != INSTR_REGION_COMP) return;
+  if (comp->ctx.pinned) return;
+
+  const auto spans = &sym->norm.spans;
+  const auto floor = spans->floor;
+  const auto ceil  = stack_len_valid(&code->code_write);
+  const auto len   = ceil - floor;
+  const auto dst   = &code->inactive;
+
+  if (stack_len_valid(&code->code_exec) > floor) return;
+  if (len > INSTR_HEAP_LEN - dst->write) return;
+  if (comp_code_commit(code, INSTR_REGION_COMP, dst->write + len)) return;
+  if (!asm_relocate_instrs(code, spans, ceil, dst->write)) return;
+
+  const auto delta = dst->write - floor;
+
+  code->code_write.top  = code->code_write.floor + floor;
+  code->valid_instr_len = floor;
+  dst->write           += len;
+  dst->valid            = dst->write;
+
+  spans->floor    += delta;
+  spans->prologue += delta;
+  spans->inner    += delta;
+  spans->epi_ok   += delta;
+  spans->epi_err  += delta;
+  spans->ret      += delta;
+  spans->data     += delta;
+  spans->ceil     += delta;
+
+  sym->norm.exec = asm_sym_prologue_executable(comp, sym);
 }
 
 static Err comp_sym_end(Comp *comp, Sym *sym) {
-  asm_sym_end(comp, sym);
-  sym_auto_inlinable(sym);
+  try(asm_sym_end(comp, sym));
+  comp_sym_settle(comp, sym);
+  if (asm_sym_inline_relocatable(&comp->code, sym)) {
+    sym_auto_inlinable(sym, comp->profile ? ASM_COUNTER_INSTR_LEN : 0);
+  }
 
 #ifndef CALL_CONV_STACK
   try(comp_check_unused_locals(&comp->ctx));
@@ -504,33 +651,6 @@ static Err comp_append_page_load(Comp *comp, Uint adr, U8 reg) {
   return nullptr;
 }
 
-static Err err_out_of_space_data() {
-  return err_str("unable to allocate static data: out of space");
-}
-
-// The resulting address is located at a significant distance from executable
-// code, and needs to be accessed via the `adrp & add/ldr` idiom.
-static Err comp_alloc_data(Comp *comp, Ind size, Ind align, const U8 **out) {
-  const auto data = &comp->code.data;
-  const auto len  = __builtin_align_up(stack_len_valid(data), align);
-  const auto cap  = stack_cap_valid(data);
-
-  if (len > cap || size > cap - len) return err_out_of_space_data();
-
-  data->top      = data->floor + len;
-  const auto adr = data->top;
-  data->top += size;
-
-  if (out) *out = adr;
-
-  IF_DEBUG(eprintf(
-    "[system] allocated data region with address %p and length " FMT_IND "\n",
-    adr,
-    size
-  ));
-  return nullptr;
-}
-
 static const char *asm_fixup_fmt(Asm_fixup *fix) {
   static thread_local char BUF[4096];
 
@@ -593,3 +713,23 @@ static Err comp_validate_main(const Sym *main) {
 
   return nullptr;
 }
+
+static Err err_sym_interp_only(const Sym *sym, const Sym *dep) {
+  return errf(
+    "unable to compile: symbol " FMT_QUOTED " used by " FMT_QUOTED
+    " is interpreter-only",
+    dep->name.buf,
+    sym->name.buf
+  );
+}
+
+static Err validate_callees_can_compile(Sym_set *visited, const Sym *sym) {
+  for (set_range(Ind, ind, &sym->callees)) {
+    const auto dep = sym->callees.vals[ind];
+    if (set_has(visited, dep)) continue;
+    set_add(visited, dep);
+    if (dep->interp_only) return err_sym_interp_only(sym, dep);
+    try(validate_callees_can_compile(visited, dep));
+  }
+  return nullptr;
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include "../clib/dict.h"
+#include "../clib/list.h"
 #include "../clib/mem.h"
 #include "../clib/num.h"
 #include "../clib/str.h"
 #include "./arch.h"
+#include "./sym.h"
 
 /*
 Book-keeping for instructions which we can't properly encode
@@ -22,6 +24,8 @@ typedef struct {
     ASM_FIX_TRY,
     ASM_FIX_THROW,
     ASM_FIX_RECUR,
+    ASM_FIX_TAIL,
+    ASM_FIX_EXTERN,
   } type;
 
   union {
@@ -34,6 +38,17 @@ typedef struct {
 
     Instr *throw; // b <epi_err>
     Instr *recur; // b <begin>
+
+    struct {
+      const Sym *callee;
+      Instr     *instr; // bl <callee>; see `asm_fixup_tail`.
+    } tail;
+
+    struct {
+      const Sym *callee;
+      Instr     *instr; // bl <stub>; see `asm_fixup_extern`.
+      Instr     *stub;  // Set when fixing up; shared by later calls.
+    } ext;
   };
 } Asm_fixup;
 
@@ -45,9 +60,43 @@ typedef stack_of(Asm_fixup) Asm_fixups;
 #include "./comp_cc_stack.h"
 #endif
 
-// 0x100000 * sizeof(Instr) = 4 MiB
+// 256 MiB of address space; see `Instr_heap` for how little of it is used.
 // SYNC[instr_heap_len].
-static constexpr Uint INSTR_HEAP_LEN = (1u << 22u) / sizeof(Instr);
+static constexpr Uint INSTR_HEAP_LEN = (1u << 28u) / sizeof(Instr);
+
+/*
+The lower half of `Instr_heap.instrs` holds runtime code, which may end up in
+an executable. The upper half holds words which only run during compilation:
+those in the comp wordlist, and those marked `comp_only` or `interp_only`.
+Keeps runtime words dense, and lets AOT skip the comptime region entirely.
+
+Instruction indexes, such as in `Sym_instrs`, are always relative to the start
+of the heap, regardless of region. See `./instr_region.c`.
+*/
+static constexpr Uint INSTR_RUNTIME_LEN = INSTR_HEAP_LEN / 2;
+
+// Pages of the writable heap are committed in steps of this many instructions.
+static constexpr Ind INSTR_COMMIT_LEN = (1u << 20u) / sizeof(Instr);
+
+/*
+Space which must remain in a region for compilation to proceed; checked at
+the start of each word and between compiled words, with a descriptive error.
+Between checks, the assembler appends far fewer instructions than this.
+*/
+static constexpr Ind INSTR_SLACK_LEN = 1u << 16u;
+
+typedef enum : U8 {
+  INSTR_REGION_RUNTIME,
+  INSTR_REGION_COMP,
+} Instr_region;
+
+// Lengths of a region, as indexes from the start of `Instr_heap.instrs`.
+typedef struct {
+  Ind write;  // Appended instructions.
+  Ind exec;   // Copied to the executable heap.
+  Ind valid;  // Finalized; may be copied.
+  Ind commit; // Writable pages are committed up to here.
+} Instr_region_lens;
 
 static constexpr Uint MAIN_ARENA_LEN = 1u << 30u;
 
@@ -60,8 +109,16 @@ Instruction addresses need to be stable because they're referenced in multiple
 places in C structures and used in Forth during compilation, by various control
 flow words such as conditionals and loops.
 
-TODO: consider writing interp-only words to a separate sector,
-allowing us to elide them from the executable.
+The size is a reservation of address space rather than memory. In the writable
+heap, pages are committed on demand; see `comp_code_commit`. The executable heap
+is backed by the OS on first write, which happens only when syncing new code.
+Small scripts touch just a few pages.
+
+Calls between words which are too far apart for `bl` (±128 MiB), such as from
+the comptime region to the runtime region, go through a veneer; see
+`asm_append_call_norm`.
+
+Split into a runtime region and a comptime region; see `INSTR_RUNTIME_LEN`.
 
 SYNC[instr_heap_fields].
 */
@@ -78,7 +135,7 @@ Sections `.intrins` and `.externs` are used for dynamic linking,
 analogous to a GOT (global offset table) in executable formats.
 */
 typedef struct {
-  Instr_heap exec;                            // 4 MiB; executable code.
+  Instr_heap exec;                            // 256 MiB; executable code.
   U8         data[1u << 29u];                 // 512 MiB; mutable values.
   U8         guard_0[MEM_PAGE];               // PROT_NONE
   U64        externs[MEM_PAGE / sizeof(U64)]; // Addresses of external symbols.
@@ -92,11 +149,25 @@ typedef struct {
 } Comp_heap;
 
 static constexpr Uint MAIN_ARENA_OFF = offsetof(Comp_heap, arena);
-static_assert(MAIN_ARENA_OFF == 0x2041C000);
+static_assert(MAIN_ARENA_OFF == 0x3001C000);
 
 static constexpr Uint MAIN_CELLS_OFF = offsetof(Comp_heap, cells);
 static_assert(MAIN_CELLS_OFF == MAIN_ARENA_OFF + MAIN_ARENA_LEN + MEM_PAGE);
 
+/*
+Static data region allocated by `comp_alloc_data`, as an offset and length
+in `Comp_heap.data`. Used by AOT linking to drop unreferenced data.
+*/
+typedef struct {
+  Ind off;
+  Ind len;
+  Ind align;
+} Data_alloc;
+
+typedef stack_of(Data_alloc) Data_allocs;
+
+static constexpr Ind DATA_ALLOCS_LEN = 1u << 18u;
+
 // Invariants: `stack_len(.addrs) == stack_len(.names) == .inds.len`.
 //
 // SYNC[comp_syms_fields].
@@ -108,21 +179,37 @@ typedef struct {
 
 // SYNC[comp_code_fields].
 typedef struct {
-  Instr_heap *write;           // Writable non-executable instructions.
-  Comp_heap  *heap;            // Executable code and data.
-  Instr_span  code_write;      // References `.code.instrs`.
-  Instr_span  code_exec;       // References `.heap.code.instrs`.
-  U8_span     data;            // References `.heap.data`.
-  Comp_syms   externs;         // Extern symbols in `.heap.externs`.
-  Comp_syms   intrins;         // Intrin symbols in `.heap.intrins`.
-  Ind         valid_instr_len; // Further instructions may be unpatched.
+  Instr_heap       *write;           // Writable non-executable instructions.
+  Comp_heap        *heap;            // Executable code and data.
+  Instr_span        code_write;      // References `.code.instrs`.
+  Instr_span        code_exec;       // References `.heap.code.instrs`.
+  U8_span           data;            // References `.heap.data`.
+  Comp_syms         externs;         // Extern symbols in `.heap.externs`.
+  Comp_syms         intrins;         // Intrin symbols in `.heap.intrins`.
+  Ind               valid_instr_len; // Further instructions may be unpatched.
+  Instr            *exec_write;      // Writable view of `.code_exec`.
+  Data_allocs       data_allocs;     // Regions of `.data`, in allocation order.
+  Instr_region      region;          // Active region of `.code_*` spans.
+  Ind               instr_commit;    // `Instr_region_lens.commit` of `.region`.
+  Instr_region_lens inactive;        // Parked state of the other region.
 } Comp_code;
 
 // SYNC[comp_code_size].
-static_assert(sizeof(Comp_code) == 288);
+static_assert(sizeof(Comp_code) == 408);
+
+// Call counter of a word compiled with `--profile`; see `comp_profile_sym`.
+typedef struct {
+  const Sym *sym;
+  Ind        off; // Offset of a `U64` in `Comp_code.data`.
+} Prof_counter;
+
+typedef list_of(Prof_counter) Prof_counters;
 
 // SYNC[comp_fields].
 typedef struct {
-  Comp_code code;
-  Comp_ctx  ctx;
+  Comp_code     code;
+  Comp_ctx      ctx;
+  Prof_counters prof;    // In definition order; the latest per word wins.
+  bool          opt;     // Arm64-only; see `asm_peephole`, `asm_fixup_extern`.
+  bool          profile; // Count calls of each word; see `comp_profile_sym`.
 } Comp;
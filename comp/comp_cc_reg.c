@@ -76,17 +76,21 @@ static void comp_ctx_trunc(Comp_ctx *ctx) {
   stack_trunc(&ctx->locals);
   dict_trunc((Dict *)&ctx->local_dict);
   arr_clear(ctx->args);
+  ptr_clear(&ctx->tail);
 
   ctx->vol_regs = BITS_ALL; // Invalid initial state for bug detection.
 
   ptr_clear(&ctx->sym);
   ptr_clear(&ctx->fp_off);
+  ptr_clear(&ctx->vec_live);
+  ptr_clear(&ctx->vec_saved);
   ptr_clear(&ctx->saved_reg);
   ptr_clear(&ctx->arg_len);
   ptr_clear(&ctx->compiling);
   ptr_clear(&ctx->redefining);
   ptr_clear(&ctx->auto_try);
   ptr_clear(&ctx->slop);
+  ptr_clear(&ctx->pinned);
 }
 
 // SYNC[comp_ctx_fields].
@@ -110,12 +114,15 @@ static void comp_ctx_rewind(const Comp_ctx *prev, Comp_ctx *next) {
   next->sym        = prev->sym;
   next->fp_off     = prev->fp_off;
   next->vol_regs   = prev->vol_regs;
+  next->vec_live   = prev->vec_live;
+  next->vec_saved  = prev->vec_saved;
   next->saved_reg  = prev->saved_reg;
   next->arg_len    = prev->arg_len;
   next->redefining = prev->redefining;
   next->compiling  = prev->compiling;
   next->auto_try   = prev->auto_try;
   next->slop       = prev->slop;
+  next->tail       = prev->tail;
 
   span_rewind(&prev->locals, &next->locals);
   dict_trunc((Dict *)&next->local_dict);
@@ -241,6 +248,42 @@ static Err comp_args_fold(
   return nullptr;
 }
 
+/*
+If the top `len` args are comptime constants, and their instructions are the
+latest ones, copies their values to `out` in register order. Used to evaluate
+pure words at compile time; see `interp_comp_call_pure`.
+*/
+static bool comp_args_imm(const Comp *comp, U8 len, Sint *out) {
+  const auto ctx = &comp->ctx;
+  if (ctx->arg_len < len) return false;
+
+  const U8 floor = (U8)(ctx->arg_len - len);
+  auto     ceil  = stack_len_valid(&comp->code.code_write);
+
+  for (U8 reg = ctx->arg_len; reg > floor; reg--) {
+    const auto arg = &ctx->args[reg - 1];
+    if (arg->type != COMP_ARG_IMM || arg->imm.ceil != ceil) return false;
+
+    out[reg - 1 - floor] = arg->imm.num;
+    ceil                 = arg->imm.floor;
+  }
+  return true;
+}
+
+// Backtracks the top `len` args, which must pass `comp_args_imm`.
+static void comp_args_drop_imm(Comp *comp, U8 len) {
+  const auto ctx   = &comp->ctx;
+  const U8   floor = (U8)(ctx->arg_len - len);
+  if (!len) return;
+
+  stack_trunc_to(&comp->code.code_write, ctx->args[floor].imm.floor);
+
+  for (U8 reg = floor; reg < ctx->arg_len; reg++) {
+    ctx->args[reg] = comp_arg_unknown();
+  }
+  ctx->arg_len = floor;
+}
+
 static Err err_args_arity(
   const Sym *sym, const char *action, Sint min, Sint max, Sint ava
 ) {
@@ -511,6 +554,103 @@ static Err comp_alloc_next_reg(Comp *comp, U8 *out) {
   return nullptr;
 }
 
+static Err comp_validate_vec_reg(Sint reg) {
+  if (reg >= 0 && reg < ASM_VEC_REG_LEN) return nullptr;
+  return errf("invalid vector register value " FMT_SINT, reg);
+}
+
+static Err comp_register_vec_clobber(Comp *comp, U8 reg) {
+  try(comp_validate_vec_reg(reg));
+  Sym *sym;
+  try(comp_require_current_sym(comp, &sym));
+
+  // Stashed and restored by the prologue and epilogue; not a clobber.
+  if (bits_has(ASM_VEC_REGS_STABLE, reg)) {
+    bits_add_to(&comp->ctx.vec_saved, reg);
+    return nullptr;
+  }
+  bits_add_to(&sym->clobber, (U8)(ASM_VEC_CLOBBER_SHIFT + reg));
+  return nullptr;
+}
+
+/*
+Vector registers are never used for locals or arguments, so allocation is
+much simpler than for GPRs: a register is either allocated or free. Words
+which emit vector instructions allocate registers for the duration of some
+instruction sequence, typically inside one `[ ]` block, and free them after.
+Whatever is still allocated is freed at the end of the word.
+
+Calls which would clobber an allocated register are rejected; see
+`comp_validate_call_vec_regs`. Scratch registers are clobbered by any
+call which uses them. Callee-saved registers cost a save and restore
+in the prologue and epilogue, but survive calls to other Forth words.
+*/
+static Err comp_alloc_vec_reg_from(Comp *comp, Bits regs, U8 *out) {
+  const auto ctx  = &comp->ctx;
+  auto       free = bits_del_all(regs, ctx->vec_live);
+
+  if (!free) {
+    return errf(
+      "unable to allocate a vector register: all %d candidates are in use",
+      bits_len(regs)
+    );
+  }
+
+  const auto reg = bits_pop_low(&free);
+  try(comp_register_vec_clobber(comp, reg));
+  bits_add_to(&ctx->vec_live, reg);
+  if (out) *out = reg;
+  return nullptr;
+}
+
+static Err comp_alloc_vec_reg(Comp *comp, U8 *out) {
+  return comp_alloc_vec_reg_from(comp, ASM_VEC_REGS_SCRATCH, out);
+}
+
+static Err comp_alloc_vec_reg_stable(Comp *comp, U8 *out) {
+  return comp_alloc_vec_reg_from(comp, ASM_VEC_REGS_STABLE, out);
+}
+
+static Err comp_free_vec_reg(Comp *comp, U8 reg) {
+  try(comp_validate_vec_reg(reg));
+  const auto ctx = &comp->ctx;
+
+  if (!bits_has(ctx->vec_live, reg)) {
+    return errf("unable to free vector register %d: not allocated", reg);
+  }
+  bits_del_from(&ctx->vec_live, reg);
+  return nullptr;
+}
+
+/*
+Declares that the following instructions clobber a specific vector register,
+for code which picks registers by hand. The register must not be allocated.
+*/
+static Err comp_realloc_vec_reg(Comp *comp, U8 reg) {
+  try(comp_validate_vec_reg(reg));
+
+  if (bits_has(comp->ctx.vec_live, reg)) {
+    return errf(
+      "unable to clobber vector register %d: currently allocated", reg
+    );
+  }
+  return comp_register_vec_clobber(comp, reg);
+}
+
+static Err comp_validate_call_vec_regs(
+  const Comp *comp, const char *name, Bits clobber
+) {
+  auto regs = comp->ctx.vec_live & (clobber >> ASM_VEC_CLOBBER_SHIFT);
+  if (!regs) return nullptr;
+
+  return errf(
+    "unable to call " FMT_QUOTED
+    ": it may clobber vector register %d, which is currently allocated",
+    name,
+    bits_pop_low(&regs)
+  );
+}
+
 // Concrete "read" operation used as a fallback by "get".
 static void comp_append_local_read(Comp *comp, Local *loc, U8 reg) {
   auto reloc = loc->reloc;
@@ -685,6 +825,7 @@ because they're opaque to us.
 */
 static Err comp_before_append_call(Comp *comp, const Sym *callee) {
   try(comp_validate_call_args(comp, callee));
+  try(comp_validate_call_vec_regs(comp, callee->name.buf, callee->clobber));
   try(comp_forget_regs(comp, callee->clobber));
   Sym *caller;
   try(comp_require_current_sym(comp, &caller));
@@ -726,6 +867,40 @@ static Err comp_after_append_call(
   return nullptr;
 }
 
+// Must be called right after appending the call, before any `try`.
+static void comp_note_tail(Comp *comp, Sym *callee, Ind floor) {
+  comp->ctx.tail = (Comp_tail){
+    .callee = callee,
+    .floor  = floor,
+    .ceil   = stack_len_valid(&comp->code.code_write),
+  };
+}
+
+/*
+If the latest call is immediately followed by the return, and its outputs are
+exactly ours, the assembler may replace it with a jump after tearing down our
+frame, so the callee returns directly to our caller. Whether the frame allows
+this is only known when finalizing the word; see `asm_fixup_tail`.
+*/
+static void comp_append_tail_call(Comp *comp) {
+  const auto ctx   = &comp->ctx;
+  const auto tail  = &ctx->tail;
+  const auto write = &comp->code.code_write;
+
+  if (!tail->callee) return;
+  if (tail->ceil != stack_len_valid(write)) return;
+  if (ctx->arg_len != tail->callee->out_len) return;
+
+  stack_push(
+    &ctx->asm_fix,
+    (Asm_fixup){
+      .type = ASM_FIX_TAIL,
+      .tail = {.callee = tail->callee, .instr = &write->floor[tail->floor]},
+    }
+  );
+  ptr_clear(tail);
+}
+
 static Err comp_append_call_norm(Comp *comp, Sym *callee, bool auto_try) {
   IF_DEBUG(try_assert(callee->type == SYM_NORM));
 
@@ -737,7 +912,9 @@ static Err comp_append_call_norm(Comp *comp, Sym *callee, bool auto_try) {
     try(asm_inline_sym(comp, caller, callee, auto_try));
   }
   else {
+    const auto floor = stack_len_valid(&comp->code.code_write);
     try(asm_append_call_norm(comp, caller, callee, auto_try));
+    comp_note_tail(comp, callee, floor);
     sym_register_call(caller, callee);
   }
 
@@ -779,7 +956,10 @@ static Err comp_before_append_ret(Comp *comp) {
 
   try(comp_validate_args(comp, "unable to compile return", min, max));
 
-  if (!sym->has_err) return nullptr;
+  if (!sym->has_err) {
+    comp_append_tail_call(comp);
+    return nullptr;
+  }
 
   const auto ctx     = &comp->ctx;
   const auto len     = ctx->arg_len;
@@ -792,7 +972,10 @@ static Err comp_before_append_ret(Comp *comp) {
   }
 
   const auto arg = &ctx->args[err_reg];
-  if (arg->type != COMP_ARG_IMM) return nullptr;
+  if (arg->type != COMP_ARG_IMM) {
+    comp_append_tail_call(comp);
+    return nullptr;
+  }
   const auto err = arg->imm.num;
   if (err) return nullptr;
 
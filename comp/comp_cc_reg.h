@@ -41,8 +41,11 @@ are used at branch points and in recursion. This simple solution
 lets us avoid a complex IR and liveness analysis.
 
 When compiling a function, we track clobbers, and when finalizing,
-we allocate one location per local, for the duration of the entire
-function, in the priority order listed above: arg > stable > mem.
+we allocate one location per local, in the priority order listed
+above: arg > stable > mem. On Arm64, locals whose live ranges don't
+overlap may share a register. Live ranges come from the positions of
+read and reloc fixups, widened to cover enclosing loops; this is the
+extent of our "liveness analysis". See `asm_fixup_locals`.
 
 When "pushing" a local to the compile-time "register stack",
 the compiler looks for registers already associated with the
@@ -84,6 +87,11 @@ typedef struct {
     U8  reg;    // For `LOC_REG` only.
     Ind fp_off; // For `LOC_MEM` only; FP offset.
   };
+
+  // Instructions `[floor,ceil)` which may access the stable location.
+  // Empty for locals without fixups. Computed when finalizing.
+  Ind live_floor;
+  Ind live_ceil;
 } Local;
 
 typedef stack_of(Local)  Loc_stack;
@@ -148,6 +156,16 @@ typedef struct {
   };
 } Comp_arg;
 
+/*
+The latest call to a Forth word. If nothing is compiled between the call and
+the return, it's a tail call; see `comp_append_tail_call`.
+*/
+typedef struct {
+  Sym *callee;
+  Ind  floor; // First instruction of the call.
+  Ind  ceil;  // Just above the last instruction of the call.
+} Comp_tail;
+
 /*
 Transient context used in compilation of a single word.
 
@@ -167,12 +185,16 @@ typedef struct {
   Ind        fp_off;                // Stack space reserved for locals.
   Comp_arg   args[ASM_ARG_LEN_MAX]; // Values in arg registers.
   Bits       vol_regs;              // Volatile registers available for locals.
+  Bits       vec_live;              // Allocated vector registers.
+  Bits       vec_saved;             // Callee-saved vector registers used.
   U8         saved_reg;  // Lowest callee-saved register used for locals.
   U8         arg_len;    // Available args for the next call or assign.
   Asm_fixups asm_fix;    // For patching instructions in a post-pass.
   Loc_fixups loc_fix;    // For resolving stable locations for locals.
+  Comp_tail  tail;       // Candidate for tail-call elimination.
   bool       redefining; // Temporarily suppress "redefined" diagnostic.
   bool       compiling;  // Turned on by `:` and `]`, turned off by `[`.
   bool       auto_try;   // Current word auto-returns callee errors.
   bool       slop;       // Disable rejection of sloppy code.
+  bool       pinned;     // Exec address observed; see `comp_sym_settle`.
 } Comp_ctx;
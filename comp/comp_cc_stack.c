@@ -64,6 +64,7 @@ static void comp_ctx_trunc(Comp_ctx *ctx) {
   ptr_clear(&ctx->fp_off);
   ptr_clear(&ctx->compiling);
   ptr_clear(&ctx->redefining);
+  ptr_clear(&ctx->pinned);
 }
 
 // SYNC[comp_ctx_fields].
@@ -32,4 +32,5 @@ typedef struct {
   bool       redefining; // Temporarily suppress "redefined" diagnostic.
   bool       compiling;  // Turned on by `:` and `]`, turned off by `[`.
   bool       has_alloca; // True if SP is dynamically adjusted in the body.
+  bool       pinned;     // Exec address observed; see `comp_sym_settle`.
 } Comp_ctx;
@@ -0,0 +1,564 @@
+/*
+AOT-compiles an ELF64 executable for Linux on Arm64 from the interpreter state,
+using JIT-compiled code, static data, and symbol dictionaries. This is the ELF
+counterpart of `./mach_o.c`; see its description for the general approach.
+
+In short: JIT-compiled code uses PC-relative addressing of data and external
+symbols, all of which are placed in `Comp_heap`. We translate its memory layout
+into `EPT_LOAD` segments which preserve the relative offsets between sections,
+allowing offsets hardcoded inside instructions to work as-is. Externs are
+located in a GOT segment; the dynamic linker patches it before running our
+code, via `ERT_AARCH64_GLOB_DAT` relocations described in `EPT_DYNAMIC`.
+
+Unlike Mach-O `MLC_MAIN`, an ELF entry point is not a C function: it gets
+`argc` and `argv` on the stack and must never return. We generate a small
+entry stub which calls `.main` with `argc` and `argv`, then tail-calls libc
+`exit` with the resulting exit code, which also flushes stdio buffers.
+
+The layout uses `MEM_PAGE` alignment, which works on kernels configured for
+4 KiB or 16 KiB pages, but not 64 KiB pages.
+
+See `../clib/elf.h` for useful links and commands.
+
+This is supported only for the register-based calling convention.
+*/
+#pragma once
+#include "../clib/elf.h"
+#include "../clib/err.h"
+#include "../clib/io.c"
+#include "../clib/mem.c"
+#include "../clib/mem.h"
+#include "../clib/set.c"
+#include "./arch.c"
+#include "./comp.c"
+#include "./interp.h"
+#include "./link.c"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+Fixed base address of the executable; the equivalent of `__PAGEZERO` in Mach-O.
+Anything below this address is unmapped, which keeps null dereferences faulty.
+*/
+static constexpr U64 ELF_BASE_VM_OFF = 1u << 22u;
+
+static constexpr char ELF_INTERP[] = "/lib/ld-linux-aarch64.so.1";
+static constexpr char ELF_LIBC[]   = "libc.so.6";
+static constexpr char ELF_EXIT[]   = "exit";
+
+// Must match the entries appended in `compile_elf_executable`.
+static constexpr U16 ELF_PROG_HEAD_COUNT = 11;
+
+// Must match the entries appended in `encode_elf_dynamic_segment`.
+static constexpr U32 ELF_DYN_COUNT = 13;
+
+// Must match the instructions appended in `encode_elf_entry_stub`.
+static constexpr U32 ELF_ENTRY_STUB_LEN = 8;
+
+static Err err_elf_got_at_capacity(Ind len) {
+  return errf(
+    "unable to build executable: too many external symbols (" FMT_IND ")", len
+  );
+}
+
+/*
+Entry stub. On entry, `sp` points to `argc`, followed by the `argv` array.
+The frame pointer and link register are zeroed to terminate stack traces.
+`x0` contains a finalizer from the dynamic linker; we ignore it, like many
+non-libc runtimes do.
+
+  mov  x29, xzr
+  mov  x30, xzr
+  ldr  x0, [sp]
+  add  x1, sp, #8
+  bl   <main>
+  adrp x16, <exit_got>@page
+  ldr  x16, [x16, <exit_got>@pageoff]
+  br   x16
+*/
+static void encode_elf_entry_stub(
+  Buf *buf, U64 stub_vm_off, U64 main_vm_off, U64 exit_got_vm_off
+) {
+  const auto base_len = buf->len;
+  const auto main_off = (Sint)(main_vm_off - stub_vm_off) / (Sint)sizeof(Instr);
+
+  // The `bl` is the 5th instruction; its offset is relative to itself.
+  const auto bl_off = main_off - 4;
+
+  constexpr U8 reg = 16;
+  const auto   adrp_vm_off = stub_vm_off + (5 * sizeof(Instr));
+  U16          pageoff;
+  const auto adrp = asm_instr_adrp(reg, adrp_vm_off, exit_got_vm_off, &pageoff);
+
+  buf_append(buf, asm_instr_mov_reg(ASM_REG_FP, ASM_REG_ZERO));
+  buf_append(buf, asm_instr_mov_reg(ASM_REG_LINK, ASM_REG_ZERO));
+  buf_append(buf, asm_instr_load_scaled_offset(ASM_PARAM_REG_0, ASM_REG_SP, 0));
+  buf_append(buf, asm_instr_add_imm(ASM_PARAM_REG_1, ASM_REG_SP, sizeof(U64)));
+  buf_append(buf, asm_instr_branch_link_to_offset(bl_off));
+  buf_append(buf, adrp);
+  buf_append(buf, asm_instr_load_scaled_offset(reg, reg, pageoff));
+  buf_append(buf, asm_instr_branch_to_reg(reg));
+
+  assert_fatal(buf->len - base_len == ELF_ENTRY_STUB_LEN * sizeof(Instr));
+}
+
+static Elf_sym elf_undef_sym(U32 name_pos) {
+  return (Elf_sym){
+    .st_name  = name_pos,
+    .st_info  = elf_sym_info(ESB_GLOBAL, EST_NOTYPE),
+    .st_shndx = ELF_SHN_UNDEF,
+  };
+}
+
+/*
+Builds the content of the last segment, which holds the data needed by the
+dynamic linker; the ELF analog of `__LINKEDIT` in Mach-O. Layout:
+
+  Elf_dyn  dynamic[ELF_DYN_COUNT];
+  Elf_sym  dynsym[1 + got_len];
+  Elf_rela rela[got_len];
+  U32      hash[2 + 1 + 1 + got_len];
+  char     dynstr[];
+
+Symbol `N+1` corresponds to GOT entry `N`. The SysV hash table is required
+by some dynamic linkers but is never used for lookups because we don't export
+anything; it has one bucket, and every chain is empty.
+
+`exit_name` is non-null when `exit` was not among the registered externs;
+in this case it takes the GOT entry just after them.
+*/
+static void encode_elf_dynamic_segment(
+  const Comp *comp,
+  U64         dyn_vm_off,
+  U64         got_vm_off,
+  Ind         got_len,
+  const char *exit_name,
+  Buf        *buf
+) {
+  const auto exts     = &comp->code.externs;
+  const auto base_len = buf->len;
+  const auto sym_len  = 1 + got_len;
+
+  const U32 dynamic_off = 0;
+  const U32 dynsym_off  = dynamic_off + (ELF_DYN_COUNT * sizeof(Elf_dyn));
+  const U32 rela_off    = dynsym_off + (sym_len * sizeof(Elf_sym));
+  const U32 hash_off    = rela_off + (got_len * sizeof(Elf_rela));
+  const U32 dynstr_off  = hash_off + ((3 + sym_len) * sizeof(U32));
+
+  // Index 0 is the initial `\0`; the library name follows.
+  constexpr U32 libc_str_pos = 1;
+  U32           dynstr_len   = libc_str_pos + sizeof(ELF_LIBC);
+
+  for (stack_range(auto, name, &exts->names)) dynstr_len += name->len + 1;
+  if (exit_name) dynstr_len += (U32)strlen(exit_name) + 1;
+
+  const Elf_dyn dyns[] = {
+    {.d_tag = EDT_NEEDED, .d_val = libc_str_pos},
+    {.d_tag = EDT_HASH, .d_val = dyn_vm_off + hash_off},
+    {.d_tag = EDT_STRTAB, .d_val = dyn_vm_off + dynstr_off},
+    {.d_tag = EDT_SYMTAB, .d_val = dyn_vm_off + dynsym_off},
+    {.d_tag = EDT_STRSZ, .d_val = dynstr_len},
+    {.d_tag = EDT_SYMENT, .d_val = sizeof(Elf_sym)},
+    {.d_tag = EDT_RELA, .d_val = dyn_vm_off + rela_off},
+    {.d_tag = EDT_RELASZ, .d_val = got_len * sizeof(Elf_rela)},
+    {.d_tag = EDT_RELAENT, .d_val = sizeof(Elf_rela)},
+    {.d_tag = EDT_FLAGS, .d_val = ELF_DF_BIND_NOW},
+    {.d_tag = EDT_FLAGS_1, .d_val = ELF_DF_1_NOW},
+    {.d_tag = EDT_DEBUG, .d_val = 0},
+    {.d_tag = EDT_NULL, .d_val = 0},
+  };
+  static_assert(arr_cap(dyns) == ELF_DYN_COUNT);
+
+  for (range(Ind, ind, arr_cap(dyns))) buf_append(buf, dyns[ind]);
+  assert_fatal(buf->len - base_len == dynsym_off);
+
+  buf_append(buf, (Elf_sym){});
+
+  {
+    U32 str_pos = libc_str_pos + sizeof(ELF_LIBC);
+
+    for (stack_range(auto, name, &exts->names)) {
+      buf_append(buf, elf_undef_sym(str_pos));
+      str_pos += name->len + 1;
+    }
+    if (exit_name) buf_append(buf, elf_undef_sym(str_pos));
+  }
+  assert_fatal(buf->len - base_len == rela_off);
+
+  for (Ind ind = 0; ind < got_len; ind++) {
+    buf_append(
+      buf,
+      (Elf_rela){
+        .r_offset = got_vm_off + (ind * sizeof(U64)),
+        .r_info   = elf_rela_info(ind + 1, ERT_AARCH64_GLOB_DAT),
+      }
+    );
+  }
+  assert_fatal(buf->len - base_len == hash_off);
+
+  buf_append(buf, (U32)1);       // nbucket
+  buf_append(buf, (U32)sym_len); // nchain
+  buf_append(buf, (U32)0);       // bucket[0]
+  for (range(Ind, ind, sym_len)) buf_append(buf, (U32)0); // chain[ind]
+  assert_fatal(buf->len - base_len == dynstr_off);
+
+  buf_append_byte(buf, '\0');
+  buf_append_bytes(buf, (const U8 *)ELF_LIBC, sizeof(ELF_LIBC));
+  for (stack_range(auto, name, &exts->names)) {
+    buf_append_bytes(buf, (const U8 *)name->buf, name->len);
+    buf_append_byte(buf, '\0');
+  }
+  if (exit_name) {
+    buf_append_bytes(buf, (const U8 *)exit_name, (Ind)strlen(exit_name) + 1);
+  }
+  assert_fatal(buf->len - base_len == dynstr_off + dynstr_len);
+}
+
+static Err compile_elf_executable(
+  Interp *interp, Buf *buf, const Sym *main, bool shake
+) {
+  try(comp_validate_main(main));
+
+  const auto comp = &interp->comp;
+  const auto code = &comp->code;
+  try(comp_code_sync(code));
+
+  {
+    deferred(set_deinit) Sym_set visited = {};
+    try(validate_callees_can_compile(&visited, main));
+  }
+
+  deferred(link_deinit) Link link = {};
+  try(link_executable(interp, main, shake, &link));
+
+  /*
+  The entry stub needs libc `exit`. Reuse its GOT entry when the program
+  already declared it as an extern; otherwise allocate one past the rest.
+  */
+  const auto  extern_count = stack_len_valid(&code->externs.addrs);
+  const auto  exit_ind_0   = dict_get_or(&code->externs.inds, ELF_EXIT, INVALID_IND);
+  const auto  has_exit     = exit_ind_0 != INVALID_IND;
+  const auto  exit_ind     = has_exit ? exit_ind_0 : (Ind)extern_count;
+  const auto  got_len      = has_exit ? (Ind)extern_count : (Ind)extern_count + 1;
+  const char *exit_name    = has_exit ? nullptr : ELF_EXIT;
+
+  if (got_len > arr_cap(code->heap->externs)) {
+    return err_elf_got_at_capacity(got_len);
+  }
+
+  /*
+  The first `EPT_LOAD` segment begins at the start of the file and includes
+  the headers, like `__TEXT` in Mach-O. The headers are followed by the
+  interpreter path and the entry stub, then by padding up to the code,
+  which must be page-aligned to preserve the `Comp_heap` layout.
+  */
+  constexpr U32 prog_head_file_off = sizeof(Elf_head);
+  constexpr U32 prog_head_size = ELF_PROG_HEAD_COUNT * sizeof(Elf_prog_head);
+  constexpr U32 interp_file_off = prog_head_file_off + prog_head_size;
+  constexpr U32 stub_file_off = __builtin_align_up(
+    interp_file_off + sizeof(ELF_INTERP), sizeof(Instr)
+  );
+  constexpr U32 stub_size = ELF_ENTRY_STUB_LEN * sizeof(Instr);
+
+  constexpr U32 text_seg_file_off  = 0;
+  constexpr U64 text_seg_vm_off    = ELF_BASE_VM_OFF;
+  constexpr U32 text_code_file_off = mem_align_page(stub_file_off + stub_size);
+  constexpr U64 text_code_vm_off   = text_seg_vm_off + text_code_file_off;
+  static_assert(is_aligned_to(text_seg_vm_off, MEM_PAGE));
+
+  const U32 text_code_real_size = link.instr_len * sizeof(Instr);
+
+  const U32 text_seg_size = mem_align_page(
+    text_code_file_off + text_code_real_size
+  );
+
+  try_assert(is_aligned_to(text_seg_size, MEM_PAGE));
+
+  // See `./mach_o.c` for why we preserve the relative offsets.
+  constexpr auto data_vm_off = text_code_vm_off + offsetof(Comp_heap, data) -
+    offsetof(Comp_heap, exec.instrs);
+
+  const auto data_file_off  = text_seg_size;
+  const auto data_real_size = link.data_len;
+  const auto data_file_size = mem_align_page(data_real_size);
+  const auto data_vm_size   = data_file_size;
+
+  try_assert(text_seg_vm_off + text_seg_size <= data_vm_off);
+  try_assert(is_aligned_to(data_file_off, MEM_PAGE));
+  try_assert(is_aligned_to(data_vm_off, MEM_PAGE));
+
+  /*
+  The GOT is zero-filled: `ERT_AARCH64_GLOB_DAT` doesn't read the existing
+  value, so there's nothing to store in the file. The dynamic linker makes
+  it read-only after relocating, as instructed by `EPT_GNU_RELRO`.
+  */
+  constexpr auto got_vm_off = text_code_vm_off + offsetof(Comp_heap, externs) -
+    offsetof(Comp_heap, exec.instrs);
+  const auto got_real_size = got_len * sizeof(U64);
+  const auto got_vm_size   = mem_align_page(got_real_size);
+
+  try_assert(data_vm_off + data_vm_size <= got_vm_off);
+  try_assert(is_aligned_to(got_vm_off, MEM_PAGE));
+
+  constexpr auto arena_vm_off = text_code_vm_off + offsetof(Comp_heap, arena) -
+    offsetof(Comp_heap, exec.instrs);
+  constexpr auto arena_vm_size = mem_align_page(MAIN_ARENA_LEN);
+
+  constexpr auto cells_vm_off = text_code_vm_off + offsetof(Comp_heap, cells) -
+    offsetof(Comp_heap, exec.instrs);
+  constexpr auto cells_real_size = sizeof(((Comp_heap *)nullptr)->cells);
+  constexpr auto cells_vm_size   = mem_align_page(cells_real_size);
+
+  // Guard pages around the cells remain unmapped, same as in `Comp_heap`.
+  static_assert(arena_vm_off + arena_vm_size + MEM_PAGE == cells_vm_off);
+  try_assert(got_vm_off + got_vm_size <= arena_vm_off);
+
+  const auto dyn_file_off = data_file_off + data_file_size;
+  const auto dyn_vm_off   = cells_vm_off + cells_vm_size + MEM_PAGE;
+
+  deferred(buf_deinit) Buf dyn = {};
+  encode_elf_dynamic_segment(
+    comp, dyn_vm_off, got_vm_off, got_len, exit_name, &dyn
+  );
+
+  const auto dyn_real_size = dyn.len;
+  const auto dyn_vm_size   = mem_align_page(dyn_real_size);
+
+  try_assert(is_aligned_to(dyn_file_off, MEM_PAGE));
+  try_assert(is_aligned_to(dyn_vm_off, MEM_PAGE));
+
+  const auto main_vm_off = text_code_vm_off + (link.main_ind * sizeof(Instr));
+  const auto stub_vm_off = text_seg_vm_off + stub_file_off;
+
+  buf_append(
+    buf,
+    (Elf_head){
+      .e_ident =
+        {
+          .magic   = {ELF_MAGIC[0], ELF_MAGIC[1], ELF_MAGIC[2], ELF_MAGIC[3]},
+          .class   = ELF_CLASS_64,
+          .data    = ELF_DATA_LSB,
+          .version = ELF_VER_CURRENT,
+          .os_abi  = ELF_OSABI_SYSV,
+        },
+      .e_type      = EFT_EXEC,
+      .e_machine   = EMT_AARCH64,
+      .e_version   = ELF_VER_CURRENT,
+      .e_entry     = stub_vm_off,
+      .e_phoff     = prog_head_file_off,
+      .e_ehsize    = sizeof(Elf_head),
+      .e_phentsize = sizeof(Elf_prog_head),
+      .e_phnum     = ELF_PROG_HEAD_COUNT,
+    }
+  );
+
+  const auto prog_head_base = buf->len;
+
+  // `EPT_PHDR` and `EPT_INTERP` must precede all `EPT_LOAD` entries.
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_PHDR,
+      .p_flags  = EPF_READ,
+      .p_offset = prog_head_file_off,
+      .p_vaddr  = text_seg_vm_off + prog_head_file_off,
+      .p_paddr  = text_seg_vm_off + prog_head_file_off,
+      .p_filesz = prog_head_size,
+      .p_memsz  = prog_head_size,
+      .p_align  = sizeof(U64),
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_INTERP,
+      .p_flags  = EPF_READ,
+      .p_offset = interp_file_off,
+      .p_vaddr  = text_seg_vm_off + interp_file_off,
+      .p_paddr  = text_seg_vm_off + interp_file_off,
+      .p_filesz = sizeof(ELF_INTERP),
+      .p_memsz  = sizeof(ELF_INTERP),
+      .p_align  = 1,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_EXEC,
+      .p_offset = text_seg_file_off,
+      .p_vaddr  = text_seg_vm_off,
+      .p_paddr  = text_seg_vm_off,
+      .p_filesz = text_seg_size,
+      .p_memsz  = text_seg_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = data_file_off,
+      .p_vaddr  = data_vm_off,
+      .p_paddr  = data_vm_off,
+      .p_filesz = data_file_size,
+      .p_memsz  = data_vm_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = got_vm_off,
+      .p_paddr  = got_vm_off,
+      .p_filesz = 0,
+      .p_memsz  = got_vm_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = arena_vm_off,
+      .p_paddr  = arena_vm_off,
+      .p_filesz = 0,
+      .p_memsz  = arena_vm_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = cells_vm_off,
+      .p_paddr  = cells_vm_off,
+      .p_filesz = 0,
+      .p_memsz  = cells_vm_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  // Writable because some dynamic linkers store into `EDT_DEBUG`.
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_LOAD,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = dyn_vm_off,
+      .p_paddr  = dyn_vm_off,
+      .p_filesz = dyn_real_size,
+      .p_memsz  = dyn_vm_size,
+      .p_align  = MEM_PAGE,
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_DYNAMIC,
+      .p_flags  = EPF_READ | EPF_WRITE,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = dyn_vm_off,
+      .p_paddr  = dyn_vm_off,
+      .p_filesz = ELF_DYN_COUNT * sizeof(Elf_dyn),
+      .p_memsz  = ELF_DYN_COUNT * sizeof(Elf_dyn),
+      .p_align  = sizeof(U64),
+    }
+  );
+
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type   = EPT_GNU_RELRO,
+      .p_flags  = EPF_READ,
+      .p_offset = dyn_file_off,
+      .p_vaddr  = got_vm_off,
+      .p_paddr  = got_vm_off,
+      .p_filesz = 0,
+      .p_memsz  = got_vm_size,
+      .p_align  = 1,
+    }
+  );
+
+  // Non-executable stack.
+  buf_append(
+    buf,
+    (Elf_prog_head){
+      .p_type  = EPT_GNU_STACK,
+      .p_flags = EPF_READ | EPF_WRITE,
+      .p_align = 16,
+    }
+  );
+
+  try_assert(buf->len - prog_head_base == prog_head_size);
+  try_assert(buf->len == interp_file_off);
+
+  buf_append_bytes(buf, (const U8 *)ELF_INTERP, sizeof(ELF_INTERP));
+
+  buf_zeropad_to(buf, stub_file_off);
+  try_assert(buf->len == stub_file_off);
+
+  encode_elf_entry_stub(
+    buf, stub_vm_off, main_vm_off, got_vm_off + (exit_ind * sizeof(U64))
+  );
+
+  // Done writing headers; pad up to the code and write various segments.
+
+  try_assert(buf->len <= text_code_file_off);
+  buf_zeropad_to(buf, text_code_file_off);
+  try_assert(buf->len == text_code_file_off);
+
+  buf_append_bytes(buf, (const U8 *)link.instrs, text_code_real_size);
+  try_assert(buf->len == text_code_file_off + text_code_real_size);
+
+  try_assert(buf->len <= data_file_off);
+  buf_zeropad_to(buf, data_file_off);
+  try_assert(buf->len == data_file_off);
+
+  buf_append_bytes(buf, link.data, data_real_size);
+  try_assert(buf->len == data_file_off + data_real_size);
+
+  try_assert(buf->len <= dyn_file_off);
+  buf_zeropad_to(buf, dyn_file_off);
+  try_assert(buf->len == dyn_file_off);
+
+  buf_append_bytes(buf, dyn.dat, dyn.len);
+  try_assert(buf->len == dyn_file_off + dyn_real_size);
+  return nullptr;
+}
+
+static Err compile_elf_executable_to(
+  Interp *interp, const char *path, const Sym *main, bool shake
+) {
+  deferred(buf_deinit) Buf buf = {};
+  try(compile_elf_executable(interp, &buf, main, shake));
+
+  // See the comment in `compile_mach_executable_to`.
+
+  FILE *file = nullptr;
+  Err   err  = nullptr;
+  if (!err) err = file_open(path, "w", &file);
+  if (!err) err = file_write(file, buf.dat, 1, buf.len);
+  if (!err) err = err_errno(fflush(file));
+  if (!err) err = err_errno(fchmod(fileno(file), 0755));
+  if (file) err = either(err, err_errno(fclose(file)));
+  return err;
+}
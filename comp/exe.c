@@ -0,0 +1,26 @@
+/*
+AOT compilation of native executables. The executable format matches
+the host platform: Mach-O on MacOS (`./mach_o.c`), ELF on Linux (`./elf.c`).
+*/
+#pragma once
+#include "./interp.h"
+
+#ifdef __APPLE__
+#include "./mach_o.c"
+#else
+#include "./elf.c"
+#endif
+
+/*
+With `shake`, the executable includes only the code and data reachable from
+`main`, rather than the entire JIT heap. See `./link.c`.
+*/
+static Err compile_executable_to(
+  Interp *interp, const char *path, const Sym *main, bool shake
+) {
+#ifdef __APPLE__
+  return compile_mach_executable_to(interp, path, main, shake);
+#else
+  return compile_elf_executable_to(interp, path, main, shake);
+#endif
+}
@@ -0,0 +1,688 @@
+/*
+Interpreter images: snapshots of a bootstrapped interpreter, which can be
+restored in another process, skipping the re-compilation of the same code.
+Bootstrapping `lang.af` otherwise dominates the startup time of scripts.
+
+  astil lang.af --save-image=lang.img
+  astil --load-image=lang.img script.af
+
+An image contains the written parts of `Comp_heap` (code, data, cells) and
+the symbols of the interpreter. JIT-compiled code and Forth data are full of
+absolute addresses of data and symbols (execution tokens). Instead of trying
+to relocate them, we restore the heap and the symbol stack at the same
+addresses where they were located in the saving process. Static data is
+mapped directly from the image file (copy-on-write), so loading costs about
+as much as a few syscalls plus copying the code.
+
+Addresses which are only valid in the saving process are not restored as-is:
+
+- Intrinsic procedures: the interpreter may be loaded at another address.
+- External symbols: libraries may be loaded at other addresses.
+- Heap-allocated tables: dicts, caller-callee sets, import paths.
+
+Intrinsics and externs are re-resolved by name, and tables are rebuilt.
+
+Limitations:
+
+- An image is only valid for the interpreter executable which produced it,
+  including its calling convention. We check this loosely via struct sizes.
+- The saved addresses may be occupied in the new process due to ASLR.
+  In this case, loading fails, and the image needs to be re-saved.
+- Forth data must not hold addresses outside of `Comp_heap` and the symbol
+  stack, such as memory from `malloc` or the address of `Interp`.
+*/
+#pragma once
+#include "../clib/err.h"
+#include "../clib/io.c"
+#include "../clib/mem.c"
+#include "../clib/mem.h"
+#include "./interp.c"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "astilimg" in little endian.
+static constexpr U64 IMAGE_MAGIC   = 0x676D'696C'6974'7361;
+static constexpr U32 IMAGE_VERSION = 3;
+
+// Byte range in an image file.
+typedef struct {
+  U64 off;
+  U64 len;
+} Image_sect;
+
+/*
+Located at the start of an image file. Sections are aligned to `U64`,
+except for `.data`, which is aligned to `MEM_PAGE` for memory mapping.
+
+SYNC[image_head_fields].
+*/
+typedef struct {
+  U64        magic;
+  U32        version;
+  U32        sym_size;    // `sizeof(Sym)`.
+  U64        heap_size;   // `sizeof(Comp_heap)`.
+  U64        interp_size; // `sizeof(Interp)`.
+  Comp_heap *heap;        // Address of `Comp_heap` in the saving process.
+  void      *syms_cellar; // Address of the symbol stack's mapping.
+  Sym       *syms_floor;  // Address of the first symbol.
+  Image_sect instrs;      // `Instr`; runtime region of the code heaps.
+  Image_sect comp_instrs; // `Instr`; comptime region of the code heaps.
+  Image_sect data;        // Bytes; mapped at `Comp_heap.data`.
+  Image_sect data_allocs; // `Data_alloc`; regions of `.data`.
+  Image_sect cells;       // `Sint`; cell stack contents.
+  Image_sect syms;        // `Sym`; copied into the symbol stack.
+  Image_sect links;       // `Ind` per symbol: index in `Comp_code.externs`.
+  Image_sect callees;     // Per symbol: `Ind` count, then `Ind` indexes.
+  Image_sect dict_exec;   // `Ind` indexes of symbols in `Interp.dict_exec`.
+  Image_sect dict_comp;   // `Ind` indexes of symbols in `Interp.dict_comp`.
+  Image_sect externs;     // `Word_str` names in `Comp_code.externs`.
+  Image_sect intrins;     // `Word_str` names in `Comp_code.intrins`.
+  Image_sect imports;     // Null-terminated realpaths of imported files.
+} Image_head;
+
+static void image_sect_beg(Buf *buf, Image_sect *sect) {
+  buf_zeropad_to(buf, __builtin_align_up(buf->len, (Ind)sizeof(U64)));
+  sect->off = buf->len;
+}
+
+static void image_sect_end(const Buf *buf, Image_sect *sect) {
+  sect->len = buf->len - sect->off;
+}
+
+static void image_sect_append(
+  Buf *buf, Image_sect *sect, const void *src, Ind len
+) {
+  image_sect_beg(buf, sect);
+  if (len) buf_append_bytes(buf, src, len);
+  image_sect_end(buf, sect);
+}
+
+static Err err_image_defining(const char *path, const Sym *sym) {
+  return errf(
+    "unable to save image " FMT_QUOTED
+    ": inside the definition of " FMT_QUOTED,
+    path,
+    sym->name.buf
+  );
+}
+
+static Err interp_image_encode(Interp *interp, Buf *buf, const char *path) {
+  const auto comp     = &interp->comp;
+  const auto code     = &comp->code;
+  const auto instrs   = code->code_write.floor;
+  const auto runtime  = comp_code_region_lens(code, INSTR_REGION_RUNTIME);
+  const auto comptime = comp_code_region_lens(code, INSTR_REGION_COMP);
+  const auto syms     = &interp->syms;
+
+  if (comp->ctx.sym) return err_image_defining(path, comp->ctx.sym);
+  try_assert(runtime.valid == runtime.write);
+  try_assert(comptime.valid == comptime.write);
+
+  Image_head head = {
+    .magic       = IMAGE_MAGIC,
+    .version     = IMAGE_VERSION,
+    .sym_size    = sizeof(Sym),
+    .heap_size   = sizeof(Comp_heap),
+    .interp_size = sizeof(Interp),
+    .heap        = code->heap,
+    .syms_cellar = syms->cellar,
+    .syms_floor  = syms->floor,
+  };
+  buf_zeropad(buf, sizeof(head));
+
+  image_sect_append(
+    buf, &head.instrs, instrs, runtime.write * (Ind)sizeof(Instr)
+  );
+  image_sect_append(
+    buf,
+    &head.comp_instrs,
+    &instrs[INSTR_RUNTIME_LEN],
+    (comptime.write - INSTR_RUNTIME_LEN) * (Ind)sizeof(Instr)
+  );
+
+  buf_zeropad_to(buf, mem_align_page(buf->len));
+  image_sect_append(
+    buf, &head.data, code->data.floor, (Ind)stack_len_bytes(&code->data)
+  );
+  buf_zeropad_to(buf, mem_align_page(buf->len)); // Mapped in whole pages.
+
+  const auto allocs = &code->data_allocs;
+  image_sect_append(
+    buf, &head.data_allocs, allocs->floor, (Ind)stack_len_bytes(allocs)
+  );
+
+  image_sect_append(
+    buf, &head.cells, interp->cells.floor, (Ind)stack_len_bytes(&interp->cells)
+  );
+  image_sect_append(buf, &head.syms, syms->floor, (Ind)stack_len_bytes(syms));
+
+  image_sect_beg(buf, &head.links);
+  for (stack_range(auto, sym, syms)) {
+    auto ind = INVALID_IND;
+    if (sym->type == SYM_EXTERN) {
+      ind = dict_get_or(&code->externs.inds, sym->link_name, INVALID_IND);
+      try_assert(ind != INVALID_IND);
+    }
+    buf_append(buf, ind);
+  }
+  image_sect_end(buf, &head.links);
+
+  image_sect_beg(buf, &head.callees);
+  for (stack_range(auto, sym, syms)) {
+    const auto callees = &sym->callees;
+    buf_append(buf, callees->len);
+
+    for (set_range(Ind, ind, callees)) {
+      const auto callee = callees->vals[ind];
+      try_assert(is_stack_elem(syms, callee));
+      buf_append(buf, stack_ind(syms, callee));
+    }
+  }
+  image_sect_end(buf, &head.callees);
+
+  const struct {
+    const Sym_dict *dict;
+    Image_sect     *sect;
+  } dicts[] = {
+    {&interp->dict_exec, &head.dict_exec},
+    {&interp->dict_comp, &head.dict_comp},
+  };
+
+  for (auto elem = dicts; elem < arr_ceil(dicts); elem++) {
+    const auto dict = elem->dict;
+    image_sect_beg(buf, elem->sect);
+
+    for (dict_range(Ind, ind, dict)) {
+      const auto sym = dict->vals[ind];
+      try_assert(is_stack_elem(syms, sym));
+      try_assert(dict->keys[ind] == sym->name.buf);
+      buf_append(buf, stack_ind(syms, sym));
+    }
+    image_sect_end(buf, elem->sect);
+  }
+
+  const auto externs = &code->externs.names;
+  const auto intrins = &code->intrins.names;
+
+  image_sect_append(
+    buf, &head.externs, externs->floor, (Ind)stack_len_bytes(externs)
+  );
+  image_sect_append(
+    buf, &head.intrins, intrins->floor, (Ind)stack_len_bytes(intrins)
+  );
+
+  const auto imports = &interp->imports;
+  image_sect_beg(buf, &head.imports);
+  for (dict_range(Ind, ind, imports)) {
+    const auto key = imports->keys[ind];
+    buf_append_bytes(buf, (const U8 *)key, (Ind)strlen(key) + 1);
+  }
+  image_sect_end(buf, &head.imports);
+
+  buf_store(buf, 0, head);
+  return nullptr;
+}
+
+static Err interp_save_image(Interp *interp, const char *path) {
+  if (!path || !path[0]) {
+    return err_str("unable to save image: missing output path");
+  }
+
+  // Code is loaded into the executable heap; anything unsynced is lost.
+  try(comp_code_sync(&interp->comp.code));
+
+  deferred(buf_deinit) Buf buf = {};
+  try(interp_image_encode(interp, &buf, path));
+
+  // See the comment in `compile_mach_executable_to`.
+
+  FILE *file = nullptr;
+  Err   err  = nullptr;
+  if (!err) err = file_open(path, "w", &file);
+  if (!err) err = file_write(file, buf.dat, 1, buf.len);
+  if (!err) err = err_errno(fflush(file));
+  if (file) err = either(err, err_errno(fclose(file)));
+  return err;
+}
+
+// Mapped image file. See `image_file_deinit`.
+typedef struct {
+  int         fdes;
+  const U8   *dat;
+  Uint        len;
+  const char *path;
+} Image_file;
+
+static void image_file_deinit(Image_file *file) {
+  if (file->dat) munmap((void *)file->dat, file->len);
+  fd_deinit(&file->fdes);
+  *file = (Image_file){.fdes = -1};
+}
+
+static Err err_image_invalid(const char *path, const char *msg) {
+  return errf("unable to load image " FMT_QUOTED ": %s", path, msg);
+}
+
+static Err image_file_open(const char *path, Image_file *out) {
+  out->path = path;
+  try(fd_open(path, O_RDONLY, &out->fdes));
+
+  struct stat info;
+  try(fd_stat(path, out->fdes, &info));
+
+  if (info.st_size < (off_t)sizeof(Image_head)) {
+    return err_image_invalid(path, "file is too short");
+  }
+
+  const auto len = (Uint)info.st_size;
+  const auto dat = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, out->fdes, 0);
+  if (dat == MAP_FAILED) return err_mmap();
+
+  out->dat = dat;
+  out->len = len;
+  return nullptr;
+}
+
+static Err image_validate_sect(
+  const Image_file *file, const Image_sect *sect, Ind align, Ind val_size
+) {
+  if (
+    sect->off <= file->len &&
+    sect->len <= file->len - sect->off &&
+    is_aligned_to(sect->off, align) &&
+    divisible_by(sect->len, val_size)
+  ) {
+    return nullptr;
+  }
+  return err_image_invalid(file->path, "malformed section");
+}
+
+static Err image_validate_head(const Image_file *file, const Image_head *head) {
+  const auto path = file->path;
+
+  if (head->magic != IMAGE_MAGIC) {
+    return err_image_invalid(path, "not an Astil image");
+  }
+  if (head->version != IMAGE_VERSION) {
+    return err_image_invalid(path, "unsupported image version");
+  }
+  if (
+    head->sym_size != sizeof(Sym) ||
+    head->heap_size != sizeof(Comp_heap) ||
+    head->interp_size != sizeof(Interp)
+  ) {
+    return err_image_invalid(
+      path, "saved by a different build of the interpreter"
+    );
+  }
+  if (!head->heap || !head->syms_cellar || !head->syms_floor) {
+    return err_image_invalid(path, "missing addresses");
+  }
+
+  constexpr Ind word = sizeof(U64);
+  try(image_validate_sect(file, &head->instrs, word, sizeof(Instr)));
+  try(image_validate_sect(file, &head->comp_instrs, word, sizeof(Instr)));
+  try(image_validate_sect(file, &head->data, MEM_PAGE, 1));
+  try(image_validate_sect(file, &head->data_allocs, word, sizeof(Data_alloc)));
+  try(image_validate_sect(file, &head->cells, word, sizeof(Sint)));
+  try(image_validate_sect(file, &head->syms, word, sizeof(Sym)));
+  try(image_validate_sect(file, &head->links, word, sizeof(Ind)));
+  try(image_validate_sect(file, &head->callees, word, sizeof(Ind)));
+  try(image_validate_sect(file, &head->dict_exec, word, sizeof(Ind)));
+  try(image_validate_sect(file, &head->dict_comp, word, sizeof(Ind)));
+  try(image_validate_sect(file, &head->externs, word, sizeof(Word_str)));
+  try(image_validate_sect(file, &head->intrins, word, sizeof(Word_str)));
+  try(image_validate_sect(file, &head->imports, word, 1));
+
+  // Data is mapped in whole pages, which must be backed by the file.
+  if (mem_align_page(head->data.len) > file->len - head->data.off) {
+    return err_image_invalid(path, "truncated data section");
+  }
+
+  const auto syms_len = head->syms.len / sizeof(Sym);
+  if (
+    syms_len > INTERP_SYMS_LEN ||
+    head->links.len != syms_len * sizeof(Ind)
+  ) {
+    return err_image_invalid(path, "malformed symbol sections");
+  }
+  return nullptr;
+}
+
+static const void *image_sect_floor(const Image_file *file, Image_sect sect) {
+  return file->dat + sect.off;
+}
+
+static const void *image_sect_ceil(const Image_file *file, Image_sect sect) {
+  return file->dat + sect.off + sect.len;
+}
+
+static Err err_image_unmappable(const char *path, const void *addr, Err err) {
+  return errf(
+    "unable to load image " FMT_QUOTED
+    ": unable to restore memory at address %p (%s); hint: the address "
+    "is likely taken by another mapping; try re-saving the image",
+    path,
+    addr,
+    err
+  );
+}
+
+/*
+Intrinsics are saved by name. The hidden `;` is not in `INTRIN`.
+Linear search is fine: it runs only once per intrinsic per image load.
+*/
+static const Sym *image_find_intrin(const char *name) {
+  if (!strcmp(name, INTRIN_SEMICOLON.name.buf)) return &INTRIN_SEMICOLON;
+
+  for (auto intrin = INTRIN; intrin < arr_ceil(INTRIN); intrin++) {
+    if (!strcmp(intrin->name.buf, name)) return intrin;
+  }
+  return nullptr;
+}
+
+static Err err_image_intrin_unknown(const char *path, const char *name) {
+  return errf(
+    "unable to load image " FMT_QUOTED ": unknown intrinsic " FMT_QUOTED,
+    path,
+    name
+  );
+}
+
+static Err image_validate_name(const Image_file *file, const Word_str *name) {
+  if (name->len < str_cap(name) && !name->buf[name->len]) return nullptr;
+  return err_image_invalid(file->path, "malformed symbol name");
+}
+
+static Err image_load_code(
+  Interp *interp, const Image_file *file, const Image_head *head
+) {
+  const auto code     = &interp->comp.code;
+  const auto write    = &code->code_write;
+  const auto len      = (Ind)(head->instrs.len / sizeof(Instr));
+  const auto comp_len = (Ind)(head->comp_instrs.len / sizeof(Instr));
+
+  if (
+    len > INSTR_RUNTIME_LEN || comp_len > INSTR_HEAP_LEN - INSTR_RUNTIME_LEN
+  ) {
+    return err_image_invalid(file->path, "too many instructions");
+  }
+
+  comp_code_select_region(code, INSTR_REGION_RUNTIME);
+  try(comp_code_commit(code, INSTR_REGION_RUNTIME, len));
+  try(comp_code_commit(code, INSTR_REGION_COMP, INSTR_RUNTIME_LEN + comp_len));
+
+  memcpy(write->floor, image_sect_floor(file, head->instrs), head->instrs.len);
+  write->top            = write->floor + len;
+  code->valid_instr_len = len;
+
+  memcpy(
+    &write->floor[INSTR_RUNTIME_LEN],
+    image_sect_floor(file, head->comp_instrs),
+    head->comp_instrs.len
+  );
+  code->inactive.write = INSTR_RUNTIME_LEN + comp_len;
+  code->inactive.valid = INSTR_RUNTIME_LEN + comp_len;
+  try(comp_code_sync(code));
+
+  const auto data = &code->data;
+  const auto size = (Ind)head->data.len;
+  if (size > stack_cap_valid(data)) {
+    return err_image_invalid(file->path, "too much data");
+  }
+
+  if (size) {
+    const auto ptr = mmap(
+      data->floor,
+      mem_align_page(size),
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_FIXED,
+      file->fdes,
+      (off_t)head->data.off
+    );
+    if (ptr == MAP_FAILED) return err_mmap();
+  }
+  data->top = data->floor + size;
+
+  const auto allocs = &code->data_allocs;
+  const auto count  = (Ind)(head->data_allocs.len / sizeof(Data_alloc));
+  if (count > stack_cap_valid(allocs)) {
+    return err_image_invalid(file->path, "too many data allocations");
+  }
+
+  memcpy(
+    allocs->floor,
+    image_sect_floor(file, head->data_allocs),
+    head->data_allocs.len
+  );
+  allocs->top = allocs->floor + count;
+
+  const auto cells = &interp->cells;
+  const auto depth = (Ind)(head->cells.len / sizeof(Sint));
+  if (depth > stack_cap_valid(cells)) {
+    return err_image_invalid(file->path, "too many cells");
+  }
+
+  memcpy(cells->floor, image_sect_floor(file, head->cells), head->cells.len);
+  cells->top = cells->floor + depth;
+  return nullptr;
+}
+
+static Err image_load_dysyms(
+  Interp *interp, const Image_file *file, const Image_head *head
+) {
+  const auto code = &interp->comp.code;
+
+  const Word_str *floor = image_sect_floor(file, head->externs);
+  const Word_str *ceil  = image_sect_ceil(file, head->externs);
+  if (ceil - floor > stack_cap(&code->externs.addrs)) {
+    return err_image_invalid(file->path, "too many external symbols");
+  }
+
+  for (auto name = floor; name < ceil; name++) {
+    try(image_validate_name(file, name));
+
+    void *addr;
+    try(find_extern(name->buf, &addr));
+    comp_register_dysym(&code->externs, name->buf, (U64)addr);
+  }
+
+  floor = image_sect_floor(file, head->intrins);
+  ceil  = image_sect_ceil(file, head->intrins);
+  if (ceil - floor > stack_cap(&code->intrins.addrs)) {
+    return err_image_invalid(file->path, "too many intrinsics");
+  }
+
+  for (auto name = floor; name < ceil; name++) {
+    try(image_validate_name(file, name));
+
+    const auto intrin = image_find_intrin(name->buf);
+    if (!intrin) return err_image_intrin_unknown(file->path, name->buf);
+    comp_register_dysym(&code->intrins, name->buf, (U64)intrin->intrin);
+  }
+  return nullptr;
+}
+
+static Err image_load_syms(
+  Interp *interp, const Image_file *file, const Image_head *head
+) {
+  const auto code     = &interp->comp.code;
+  const auto externs  = &code->externs;
+  const auto syms     = &interp->syms;
+  const auto syms_len = (Ind)(head->syms.len / sizeof(Sym));
+  const Ind *links    = image_sect_floor(file, head->links);
+
+  if (syms->floor != head->syms_floor) {
+    return err_image_invalid(file->path, "misplaced symbol stack");
+  }
+
+  memcpy(syms->floor, image_sect_floor(file, head->syms), head->syms.len);
+  syms->top = syms->floor + syms_len;
+
+  for (stack_range(auto, sym, syms)) {
+    // Heap-allocated in the saving process; rebuilt below.
+    sym->callees = (Sym_set){};
+    sym->callers = (Sym_set){};
+    try(image_validate_name(file, &sym->name));
+
+    switch (sym->type) {
+      case SYM_NORM: {
+        if (!comp_code_is_sym_ready(code, sym)) {
+          return err_image_invalid(file->path, "malformed symbol spans");
+        }
+        break;
+      }
+
+      case SYM_INTRIN: {
+        const auto intrin = image_find_intrin(sym->name.buf);
+        if (!intrin || intrin->wordlist != sym->wordlist) {
+          return err_image_intrin_unknown(file->path, sym->name.buf);
+        }
+        sym->intrin = intrin->intrin;
+        break;
+      }
+
+      case SYM_EXTERN: {
+        const auto ind = links[stack_ind(syms, sym)];
+        if (ind >= stack_len_valid(&externs->addrs)) {
+          return err_image_invalid(file->path, "malformed extern link");
+        }
+        sym->exter     = (void *)externs->addrs.floor[ind];
+        sym->link_name = externs->names.floor[ind].buf;
+        break;
+      }
+
+      default: return err_image_invalid(file->path, "unknown symbol type");
+    }
+  }
+
+  return nullptr;
+}
+
+static Err err_image_refs(const char *path) {
+  return err_image_invalid(path, "malformed symbol references");
+}
+
+static Err image_load_refs(
+  Interp *interp, const Image_file *file, const Image_head *head
+) {
+  const auto syms     = &interp->syms;
+  const auto syms_len = stack_len_valid(syms);
+  const Ind *floor    = image_sect_floor(file, head->callees);
+  const Ind *ceil     = image_sect_ceil(file, head->callees);
+
+  for (stack_range(auto, caller, syms)) {
+    if (floor >= ceil) return err_image_refs(file->path);
+
+    auto len = *floor++;
+    if (len > ceil - floor) return err_image_refs(file->path);
+
+    while (len--) {
+      const auto ind = *floor++;
+      if (ind >= syms_len) return err_image_refs(file->path);
+      sym_register_call(caller, &syms->floor[ind]);
+    }
+  }
+  if (floor != ceil) return err_image_refs(file->path);
+
+  const struct {
+    Sym_dict  *dict;
+    Image_sect sect;
+  } dicts[] = {
+    {&interp->dict_exec, head->dict_exec},
+    {&interp->dict_comp, head->dict_comp},
+  };
+
+  for (auto elem = dicts; elem < arr_ceil(dicts); elem++) {
+    floor = image_sect_floor(file, elem->sect);
+    ceil  = image_sect_ceil(file, elem->sect);
+
+    for (; floor < ceil; floor++) {
+      if (*floor >= syms_len) return err_image_refs(file->path);
+      const auto sym = &syms->floor[*floor];
+      dict_set(elem->dict, sym->name.buf, sym);
+    }
+  }
+  return nullptr;
+}
+
+static Err image_load_imports(
+  Interp *interp, const Image_file *file, const Image_head *head
+) {
+  const char *floor = image_sect_floor(file, head->imports);
+  const char *ceil  = image_sect_ceil(file, head->imports);
+
+  while (floor < ceil) {
+    const auto len = strnlen(floor, (Uint)(ceil - floor));
+    if (floor + len >= ceil) {
+      return err_image_invalid(file->path, "malformed import paths");
+    }
+
+    char *const path = strdup(floor);
+    if (!path) return errf("unable to allocate import path " FMT_QUOTED, floor);
+
+    dict_set(&interp->imports, path, EMPTY); // The dict owns the key copy.
+    floor += len + 1;
+  }
+  return nullptr;
+}
+
+/*
+Replaces the entire interpreter state with the state from the given image.
+Process-specific fields such as CLI args and flags are preserved.
+*/
+static Err interp_load_image(Interp *interp, const char *path) {
+  if (!path || !path[0]) {
+    return err_str("unable to load image: missing input path");
+  }
+
+  deferred(image_file_deinit) Image_file file = {.fdes = -1};
+  try(image_file_open(path, &file));
+
+  Image_head head;
+  memcpy(&head, file.dat, sizeof(head));
+  try(image_validate_head(&file, &head));
+
+  const auto argc     = interp->argc;
+  const auto argv     = interp->argv;
+  const auto welcomed = interp->welcomed;
+  const auto slop     = interp->slop;
+  const auto opt      = interp->comp.opt;
+  const auto profile  = interp->comp.profile;
+
+  // Frees the addresses which we're about to claim, if they overlap.
+  try(interp_deinit(interp));
+
+  const auto err = interp_init_mem(interp, head.heap, head.syms_cellar);
+  if (err) {
+    // The symbol stack is mapped first.
+    const auto addr = interp->syms.floor ? (void *)head.heap : head.syms_cellar;
+    return err_image_unmappable(path, addr, err);
+  }
+
+  interp->argc         = argc;
+  interp->argv         = argv;
+  interp->welcomed     = welcomed;
+  interp->slop         = slop;
+  interp->comp.opt     = opt;
+  interp->comp.profile = profile;
+
+  try(image_load_code(interp, &file, &head));
+  try(image_load_dysyms(interp, &file, &head));
+  try(image_load_syms(interp, &file, &head));
+  try(image_load_refs(interp, &file, &head));
+  try(image_load_imports(interp, &file, &head));
+  try(interp_snapshot(interp));
+
+  IF_DEBUG(eprintf(
+    "[system] loaded image " FMT_QUOTED "; heap: %p; symbols: " FMT_SINT "\n",
+    path,
+    interp->comp.code.heap,
+    stack_len(&interp->syms)
+  ));
+  return nullptr;
+}
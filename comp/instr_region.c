@@ -0,0 +1,162 @@
+/*
+Bookkeeping for the runtime and comptime regions of `Instr_heap`.
+See `INSTR_RUNTIME_LEN` for the rationale.
+
+The floors of `Comp_code.code_write` and `.code_exec` are always at the start
+of the heap, so instruction indexes are comparable between regions. Only their
+tops and ceils follow the active region, which is where the assembler appends.
+The lengths of the other region are parked in `Comp_code.inactive`.
+*/
+#pragma once
+#include "../clib/err.h"
+#include "../clib/fmt.h"
+#include "../clib/jit.c"
+#include "../clib/mem.c"
+#include "../clib/stack.c"
+#include "./comp.h"
+#include "./sym.h"
+#include <string.h>
+
+static Instr_region instr_region_of(Ind ind) {
+  return ind < INSTR_RUNTIME_LEN ? INSTR_REGION_RUNTIME : INSTR_REGION_COMP;
+}
+
+static Ind instr_region_ceil(Instr_region region) {
+  return region == INSTR_REGION_RUNTIME ? INSTR_RUNTIME_LEN : INSTR_HEAP_LEN;
+}
+
+static Instr_region_lens comp_code_region_lens(
+  const Comp_code *code, Instr_region region
+) {
+  if (region != code->region) return code->inactive;
+
+  return (Instr_region_lens){
+    .write  = stack_len_valid(&code->code_write),
+    .exec   = stack_len_valid(&code->code_exec),
+    .valid  = code->valid_instr_len,
+    .commit = code->instr_commit,
+  };
+}
+
+// Makes the given region the target of further assembly.
+static void comp_code_select_region(Comp_code *code, Instr_region region) {
+  if (region == code->region) return;
+
+  const auto prev  = comp_code_region_lens(code, code->region);
+  const auto next  = code->inactive;
+  const auto ceil  = instr_region_ceil(region);
+  const auto write = &code->code_write;
+  const auto exec  = &code->code_exec;
+
+  write->top            = write->floor + next.write;
+  write->ceil           = write->floor + ceil;
+  exec->top             = exec->floor + next.exec;
+  exec->ceil            = exec->floor + ceil;
+  code->valid_instr_len = next.valid;
+  code->instr_commit    = next.commit;
+  code->inactive        = prev;
+  code->region          = region;
+}
+
+static Err err_out_of_space_code(Instr_region region) {
+  return errf(
+    "unable to compile: out of space in the %s region of the code heap "
+    "(" FMT_IND " MiB)",
+    region == INSTR_REGION_RUNTIME ? "runtime" : "comptime",
+    (Ind)((INSTR_HEAP_LEN - INSTR_RUNTIME_LEN) * sizeof(Instr) >> 20u)
+  );
+}
+
+/*
+Commits pages of the writable heap, so that the given region can be written
+up to `len`, as an index from the start of the heap. Until then, its pages
+are reserved but inaccessible, and cost no memory.
+*/
+static Err comp_code_commit(Comp_code *code, Instr_region region, Ind len) {
+  const auto commit = region == code->region ? &code->instr_commit
+                                             : &code->inactive.commit;
+  if (len <= *commit) return nullptr;
+
+  const auto ceil = instr_region_ceil(region);
+  if (len > ceil) return err_out_of_space_code(region);
+
+  auto next = __builtin_align_up(len, INSTR_COMMIT_LEN);
+  if (next > ceil) next = ceil;
+
+  try(mem_protect(
+    &code->write->instrs[*commit],
+    (next - *commit) * (Ind)sizeof(Instr),
+    PROT_READ | PROT_WRITE
+  ));
+  *commit = next;
+  return nullptr;
+}
+
+/*
+Called before compiling anything into the active region. Reports running out
+of space while there's still some slack, so that we can fail with an error
+rather than crash in the middle of assembling something.
+*/
+static Err comp_code_ensure_space(Comp_code *code) {
+  const auto len = stack_len_valid(&code->code_write);
+  if (len + INSTR_SLACK_LEN > instr_region_ceil(code->region)) {
+    return err_out_of_space_code(code->region);
+  }
+  return comp_code_commit(code, code->region, len + INSTR_SLACK_LEN);
+}
+
+static bool comp_code_is_instr_ours(const Comp_code *code, const Instr *addr) {
+  const auto floor = code->code_exec.floor;
+  if (addr < floor || addr >= floor + INSTR_HEAP_LEN) return false;
+
+  const auto ind = (Ind)(addr - floor);
+  return ind < comp_code_region_lens(code, instr_region_of(ind)).exec;
+}
+
+static const Instr *comp_sym_exec_instr(const Comp *comp, const Sym *sym) {
+  IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
+  const auto code = &comp->code;
+  const auto ind  = sym->norm.spans.prologue;
+  const auto lens = comp_code_region_lens(code, instr_region_of(ind));
+  return ind < lens.exec ? &code->code_exec.floor[ind] : nullptr;
+}
+
+// Copies finalized instructions in `[floor, ceil)` to the executable heap.
+static Err comp_code_sync_range(Comp_code *code, Ind floor, Ind ceil) {
+  if (ceil <= floor) return nullptr;
+
+  const auto beg = &code->code_exec.floor[floor];
+  const auto len = (Uint)(ceil - floor) * sizeof(Instr);
+  try_assert(len < IND_MAX);
+  IF_DEBUG(try_assert(ceil <= INSTR_HEAP_LEN));
+
+  const auto dst = code->exec_write + floor;
+  try(jit_before_write(beg, dst, (Ind)len));
+  memcpy(dst, &code->code_write.floor[floor], len);
+  try(jit_after_write(beg, dst, (Ind)len));
+  return nullptr;
+}
+
+static Err comp_code_sync(Comp_code *code) {
+  const auto exec     = &code->code_exec;
+  const auto exec_len = stack_len_valid(exec);
+  const auto inactive = &code->inactive;
+
+  if (code->valid_instr_len > exec_len) {
+    try(comp_code_sync_range(code, exec_len, code->valid_instr_len));
+    exec->top = exec->floor + code->valid_instr_len;
+  }
+
+  if (inactive->valid > inactive->exec) {
+    try(comp_code_sync_range(code, inactive->exec, inactive->valid));
+    inactive->exec = inactive->valid;
+  }
+  return nullptr;
+}
+
+static bool comp_code_is_sym_ready(const Comp_code *code, const Sym *sym) {
+  IF_DEBUG(assert_fatal(sym->type == SYM_NORM));
+  const auto spans = &sym->norm.spans;
+  return comp_code_region_lens(code, instr_region_of(spans->floor)).exec >=
+    spans->ceil;
+}
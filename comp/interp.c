@@ -62,37 +62,22 @@ static Err interp_deinit(Interp *interp) {
 static Err interp_init_syms(Interp *interp) {
   static constexpr Ind intrin_len = (Ind)arr_cap(INTRIN);
 
+  const auto syms   = &interp->syms;
+  const auto comp   = &interp->comp;
+  const auto dysyms = &comp->code.intrins;
+
   /*
-  We have two wordlists (exec and comp), but currently restrict intrinsic
-  words to just one namespace due to limitations of `comp_register_dysym`.
+  Pre-sized so that registering intrinsics never rehashes, even if they all
+  land in one wordlist. This also leaves room for the first words of the
+  prelude. Runs before anything else is registered.
   */
-  deferred(dict_deinit) Str_set names = {};
-  dict_init(&names, round_up_pow2_Ind(intrin_len * 2));
+  const auto cap = round_up_pow2_Ind(intrin_len * 2);
+  dict_init(&interp->dict_exec, cap);
+  dict_init(&interp->dict_comp, cap);
+  dict_init(&dysyms->inds, cap);
 
-  for (auto intrin = INTRIN; intrin < arr_ceil(INTRIN); intrin++) {
-    const auto prev_len = names.len;
-    dict_set(&names, intrin->name.buf, EMPTY);
-    if (names.len == prev_len) {
-      return errf("duplicate intrinsic name " FMT_QUOTED, intrin->name.buf);
-    }
-  }
-
-  const auto syms = &interp->syms;
-  const auto comp = &interp->comp;
-
-  // Hidden XT for standard Forth `;`.
-  // Used by defining words that push an XT for `end` to pop and call.
-  sym_init_intrin(stack_push(
-    syms,
-    (Sym){
-      .name.buf  = ";",
-      .wordlist  = WORDLIST_COMP,
-      .intrin    = (void *)intrin_semicolon,
-      .out_len   = 1,
-      .has_err   = true,
-      .comp_only = true,
-    }
-  ));
+  // Must be first; see `interp_semicolon_sym`.
+  sym_init_intrin(stack_push(syms, INTRIN_SEMICOLON));
 
   for (auto intrin = INTRIN; intrin < arr_ceil(INTRIN); intrin++) {
     const auto sym = stack_push(syms, *intrin);
@@ -105,26 +90,38 @@ static Err interp_init_syms(Interp *interp) {
     IF_DEBUG(try_assert(!dict_has(dict, sym->name.buf)));
     dict_set(dict, sym->name.buf, sym);
 
-    const auto syms = &comp->code.intrins;
-    comp_register_dysym(syms, sym->name.buf, (U64)sym->intrin);
+    /*
+    We have two wordlists (exec and comp), but currently restrict intrinsic
+    words to just one namespace due to limitations of `comp_register_dysym`,
+    which is keyed by name. It returns the existing entry for a known name,
+    so a duplicate shows up as a length which didn't grow. This replaces a
+    separate scratch set of names.
+    */
+    const auto prev_len = dysyms->inds.len;
+    comp_register_dysym(dysyms, sym->name.buf, (U64)sym->intrin);
+    if (dysyms->inds.len == prev_len) {
+      return errf("duplicate intrinsic name " FMT_QUOTED, sym->name.buf);
+    }
   }
 
   IF_DEBUG({
-    const auto syms = &comp->code.intrins;
-
-    try_assert(stack_len_valid(&syms->addrs) == intrin_len);
-    try_assert(stack_len_valid(&syms->names) == intrin_len);
-    try_assert(syms->inds.len == intrin_len);
+    try_assert(stack_len_valid(&dysyms->addrs) == intrin_len);
+    try_assert(stack_len_valid(&dysyms->names) == intrin_len);
+    try_assert(dysyms->inds.len == intrin_len);
   });
   return nullptr;
 }
 
-static Err interp_init(Interp *interp) {
+/*
+Allocates the memory of a blank interpreter, without any symbols.
+Non-null addresses are used when restoring an image; see `./image.c`.
+*/
+static Err interp_init_mem(Interp *interp, void *heap_addr, void *syms_addr) {
   *interp       = (Interp){};
-  Stack_opt opt = {.len = 4096};
+  Stack_opt opt = {.len = INTERP_SYMS_LEN, .addr = syms_addr};
 
   try(stack_init(&interp->syms, &opt));
-  try(comp_init(&interp->comp));
+  try(comp_init(&interp->comp, heap_addr));
 
   const auto heap = interp->comp.code.heap;
 
@@ -133,13 +130,16 @@ static Err interp_init(Interp *interp) {
     {.top = heap->cells, .ceil = arr_ceil(heap->cells), .floor = heap->cells}
   );
 
-  try(interp_init_syms(interp)); // Requires `comp_init` first.
-
   ptr_set(
     &interp->ctx,
     {.self = interp, .top = heap->arena, .ceil = arr_ceil(heap->arena)}
   );
+  return nullptr;
+}
 
+static Err interp_init(Interp *interp) {
+  try(interp_init_mem(interp, nullptr, nullptr));
+  try(interp_init_syms(interp)); // Requires `comp_init` first.
   try(interp_snapshot(interp));
 
   IF_DEBUG({
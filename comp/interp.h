@@ -5,6 +5,8 @@
 #include "./read.h"
 #include "./sym.h"
 
+static constexpr Ind INTERP_SYMS_LEN = 4096;
+
 // SYNC[interp_snap_fields].
 typedef struct {
   Comp      comp;
@@ -78,8 +80,8 @@ static_assert(CTX_CELLS_TOP == 24);
 static constexpr auto INTERP_COMP_CODE_WRITE_OFF = offsetof(
   Interp, comp.code.write
 );
-static_assert(INTERP_COMP_CODE_WRITE_OFF == 208);
+static_assert(INTERP_COMP_CODE_WRITE_OFF == 280);
 
 // SYNC[interp_data_off].
 static constexpr auto INTERP_DATA_OFF = offsetof(Interp, comp.code.data);
-static_assert(INTERP_DATA_OFF == 272);
+static_assert(INTERP_DATA_OFF == 344);
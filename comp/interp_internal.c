@@ -9,6 +9,11 @@
 #include <dlfcn.h>
 #include <stddefer.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifndef __APPLE__
+#include "../clib/sig_exc.c"
+#endif
 
 static Err comp_snapshot(const Comp *prev, Comp *next) {
   try(comp_ctx_snapshot(&prev->ctx, &next->ctx));
@@ -23,33 +28,61 @@ static Err interp_snapshot(Interp *interp) {
   return nullptr;
 }
 
+static Err interp_wordlist(Interp *, Wordlist, Sym_dict **);
+
+/*
+Makes the symbol the wordlist entry for its name, remembering the entry it
+replaces, so that `interp_forget_sym` can restore it without searching.
+*/
+static void interp_dict_set(Sym_dict *dict, Sym *sym) {
+  const auto name = sym->name.buf;
+  sym->shadowed   = dict_get(dict, name);
+  dict_set(dict, name, sym);
+}
+
+/*
+Drops a symbol which is about to be rewound from its wordlist, if the
+wordlist still refers to it. When the symbol had replaced an older one,
+that one takes its place again. Symbols are forgotten newest first, so
+when the older one is also being rewound, its own predecessor follows.
+*/
+static Err interp_forget_sym(Interp *interp, const Sym *sym) {
+  Sym_dict *dict;
+  try(interp_wordlist(interp, sym->wordlist, &dict));
+
+  const auto ind = dict_ind(dict, sym->name.buf);
+  if (ind == INVALID_IND || dict->vals[ind] != sym) return nullptr;
+  dict_del_at((Dict *)dict, ind);
+
+  const auto prev = sym->shadowed;
+  if (prev) dict_set(dict, prev->name.buf, prev);
+  return nullptr;
+}
+
 /*
 Restores the interpreter to a known consistent state.
 Should be used when handling REPL and import errors.
 
-TODO: drop currently defined symbol from list and dict.
-Our dicts don't support deletion at the moment.
+Symbols defined since the snapshot are dropped from the wordlists before
+their slots are released, which costs one dict deletion per symbol, plus
+an insertion for each redefinition. Their names are borrowed by dict keys,
+so leaving them in place would corrupt the wordlists once the slots are
+reused.
 */
 static Err interp_rewind(Interp *interp) {
   const auto prev = &interp->snap;
   const auto sym  = interp->comp.ctx.sym;
+  const auto ceil = prev->syms.top;
+
+  for (auto next = interp->syms.top; next > ceil;) {
+    next--;
+    try(interp_forget_sym(interp, next));
+  }
 
   comp_rewind(&prev->comp, &interp->comp);
   span_rewind(&prev->cells, &interp->cells);
   span_rewind(&prev->syms, &interp->syms);
 
-  /*
-  TODO: support deletion in dicts. For now, accessing a partially
-  defined word after recovering from an error is UB.
-
-    const auto len_next = stack_len_valid(syms);
-    const auto words = &interp->words;
-    for (Ind ind = len_prev; ind < len_next; ind++) {
-      const auto sym = &syms->floor[ind];
-      dict_del(words, sym->buf.name);
-    }
-  */
-
   if (!sym) {
     IF_DEBUG(eprintf("[debug] rewound interpreter state\n"));
     return nullptr;
@@ -203,13 +236,19 @@ static Err interp_call_norm(Interp *interp, const Sym *sym) {
   try(comp_code_ensure_sym_ready(&interp->comp.code, sym));
   const auto fun = comp_sym_exec_instr(&interp->comp, sym);
 
-  IF_DEBUG(eprintf(
-    "[system] calling word " FMT_QUOTED
-    " at instruction address %p (" READ_POS_FMT ")\n",
-    sym->name.buf,
-    fun,
-    READ_POS_ARGS(interp_reader(interp))
-  ));
+  IF_DEBUG({
+    // Successive calls then resume from the mark instead of rescanning.
+    const auto read = interp_reader(interp);
+    reader_mark(read);
+
+    eprintf(
+      "[system] calling word " FMT_QUOTED
+      " at instruction address %p (" READ_POS_FMT ")\n",
+      sym->name.buf,
+      fun,
+      READ_POS_ARGS(read)
+    );
+  });
 
   const auto err = asm_call_norm(interp, sym);
 
@@ -281,6 +320,61 @@ static Err interp_call_sym(Interp *interp, const Sym *sym) {
   }
 }
 
+#ifndef CALL_CONV_STACK
+
+/*
+When every input of a pure word is a comptime constant, calls the word right
+away, and compiles its outputs as constants instead of compiling the call.
+Words without errors only; failures must remain runtime errors.
+*/
+static Err interp_comp_call_pure(Interp *interp, Sym *sym, bool *done) {
+  const auto comp    = &interp->comp;
+  const auto inp_len = sym->inp_len;
+  const auto out_len = sym->out_len;
+
+  *done = false;
+  if (!sym->pure || sym->has_err || sym->type != SYM_NORM) return nullptr;
+  if (sym == comp->ctx.sym || comp->ctx.arg_len != inp_len) return nullptr;
+
+  Sint inps[ASM_INP_PARAM_REG_LEN];
+  Sint outs[ASM_OUT_PARAM_REG_LEN];
+  try_assert(inp_len <= arr_cap(inps));
+  try_assert(out_len <= arr_cap(outs));
+  if (!comp_args_imm(comp, inp_len, inps)) return nullptr;
+
+  for (U8 ind = 0; ind < inp_len; ind++) {
+    try(cell_stack_push(&interp->cells, inps[ind]));
+  }
+  try(interp_call_norm(interp, sym));
+  for (U8 ind = out_len; ind > 0; ind--) {
+    try(cell_stack_pop(&interp->cells, &outs[ind - 1]));
+  }
+
+  comp_args_drop_imm(comp, inp_len);
+  for (U8 ind = 0; ind < out_len; ind++) {
+    try(comp_append_push_imm(comp, outs[ind]));
+  }
+
+  IF_DEBUG(eprintf(
+    "[system] evaluated call of pure word " FMT_QUOTED " at compile time\n",
+    sym->name.buf
+  ));
+  *done = true;
+  return nullptr;
+}
+
+#endif // CALL_CONV_STACK
+
+static Err interp_comp_call_sym(Interp *interp, Sym *sym) {
+#ifndef CALL_CONV_STACK
+  bool done;
+  try(interp_comp_call_pure(interp, sym, &done));
+  if (done) return nullptr;
+#endif // CALL_CONV_STACK
+
+  return comp_append_call_sym(&interp->comp, sym);
+}
+
 static Err err_word_undefined(const char *name) {
   return errf("undefined word " FMT_QUOTED, name);
 }
@@ -315,16 +409,16 @@ static bool interp_name_exists(Interp *interp, const char *name) {
     dict_has(&interp->dict_exec, name);
 }
 
-static Err interp_err_word_undefined(Interp *interp, Word_str word) {
-  const auto name = word.buf;
+static Err interp_err_word_undefined(Interp *interp, const Word_str *word) {
+  const auto name = word->buf;
 
   if (name[0] == '.' && name[1] && interp_name_exists(interp, name + 1)) {
     return err_word_undefined_use(name, name + 1);
   }
 
-  if (is_word_ident_like(word) && word.len + 1 < str_cap(&word)) {
-    Word_str dotted = {.len = word.len + 1, .buf = "."};
-    memcpy(dotted.buf + 1, word.buf, word.len + 1);
+  if (is_word_ident_like(*word) && word->len + 1 < str_cap(word)) {
+    Word_str dotted = {.len = word->len + 1, .buf = "."};
+    memcpy(dotted.buf + 1, word->buf, word->len + 1);
     if (interp_name_exists(interp, dotted.buf)) {
       return err_word_undefined_use(name, dotted.buf);
     }
@@ -333,31 +427,38 @@ static Err interp_err_word_undefined(Interp *interp, Word_str word) {
   return err_word_undefined(name);
 }
 
-static Err interp_word(Interp *interp, Word_str word) {
+/*
+The word is hashed once, and the same key is used for every lookup:
+locals, then both wordlists. Words are borrowed rather than copied.
+*/
+static Err interp_word(Interp *interp, const Word_str *word) {
   const auto dict_exec = &interp->dict_exec;
   const auto dict_comp = &interp->dict_comp;
   const auto comp      = &interp->comp;
   const auto ctx       = &comp->ctx;
 
-  const auto name = word.buf;
+  const auto name = word->buf;
+  const auto key  = dict_key_len(name, word->len);
 
   if (ctx->compiling) {
-    const auto loc = comp_local_get(comp, name);
+    try(comp_code_ensure_space(&comp->code));
+
+    const auto loc = comp_local_get_key(comp, key);
     if (loc) return comp_append_push_from_local(comp, loc);
 
-    auto sym = dict_get(dict_comp, name);
+    auto sym = dict_get_key(dict_comp, key);
     if (sym) return interp_call_sym(interp, sym);
 
-    sym = dict_get(dict_exec, name);
-    if (sym) return comp_append_call_sym(comp, sym);
+    sym = dict_get_key(dict_exec, key);
+    if (sym) return interp_comp_call_sym(interp, sym);
 
     return interp_err_word_undefined(interp, word);
   }
 
-  auto sym = dict_get(dict_exec, name);
+  auto sym = dict_get_key(dict_exec, key);
   if (sym) return interp_call_sym(interp, sym);
 
-  sym = dict_get(dict_comp, name);
+  sym = dict_get_key(dict_comp, key);
   if (sym) {
     if (sym->comp_only && !ctx->sym) return err_word_comp_only(name);
     return interp_call_sym(interp, sym);
@@ -373,7 +474,7 @@ static Err read_interp_word(Interp *interp) {
 
   IF_DEBUG(eprintf("[system] read word: " FMT_QUOTED "\n", word.buf));
 
-  return interp_word(interp, word);
+  return interp_word(interp, &word);
 }
 
 static const Err ERR_QUIT = "quit";
@@ -565,13 +666,16 @@ static Err interp_import_inner(
     return nullptr;
   }
 
-  deferred(chars_deinit) char *src = nullptr;
-  Uint                         len;
-  try(file_read_text(path, &src, &len));
+  /*
+  Borrowed by the reader only while interpreting the file. Anything which
+  outlives the import, such as string literals, is copied into `data`.
+  */
+  deferred(file_text_deinit) File_text text = {};
+  try(file_map_text(path, &text));
 
   const auto read = interp_reader(interp);
 
-  *read = (Reader){.src = src, .len = (Ind)len, .path = path};
+  *read = (Reader){.src = text.buf, .len = (Ind)text.len, .path = path};
 
   // Registering the import before interpreting the file
   // enables partial cyclic imports and reduces surprise.
@@ -650,8 +754,23 @@ static Err interp_parse_until(
   return nullptr;
 }
 
+/*
+Externs which JIT code calls through our own wrappers. AOT executables don't
+run our signal handler, and link the originals by name.
+*/
+static void *find_extern_override(const char *name) {
+#ifdef __APPLE__
+  (void)name;
+#else
+  // Threads spawned by Forth code need their own alternate signal stacks.
+  if (!strcmp(name, "pthread_create")) return (void *)sig_pthread_create;
+#endif
+  return nullptr;
+}
+
 static Err find_extern(const char *name, void **out) {
-  const auto addr = dlsym(RTLD_DEFAULT, name);
+  auto addr = find_extern_override(name);
+  if (!addr) addr = dlsym(RTLD_DEFAULT, name);
 
   if (!addr) {
     return errf(
@@ -726,12 +845,11 @@ static Err interp_extern_fun(
       .link_name = stable_link_name,
       .inp_len   = (U8)inp_len,
       .out_len   = (U8)out_len,
-      .clobber   = ASM_REGS_VOLATILE, // Only used in reg-based call-conv.
+      .clobber   = SYM_CLOBBER_FOREIGN, // Only used in reg-based call-conv.
     }
   );
 
-  const auto dict = &interp->dict_exec;
-  dict_set(dict, sym->name.buf, sym);
+  interp_dict_set(&interp->dict_exec, sym);
   return nullptr;
 }
 
@@ -58,7 +58,7 @@ static Err interp_word_begin(Interp *interp, Wordlist wordlist, Word_str name) {
     }
   );
 
-  comp_sym_beg(&interp->comp, sym);
+  try(comp_sym_beg(&interp->comp, sym));
 
 #ifndef CALL_CONV_STACK
   interp->comp.ctx.slop = interp->module ? interp->module->slop : interp->slop;
@@ -86,7 +86,6 @@ static Err intrin_semicolon(Interp *interp) {
   try(interp_require_current_sym(interp, &sym));
   try(sym_validate_name(sym));
   try(comp_sym_end(comp, sym));
-  try(interp_snapshot(interp));
 
   const auto name     = sym->name.buf;
   const auto wordlist = sym->wordlist;
@@ -94,8 +93,10 @@ static Err intrin_semicolon(Interp *interp) {
   Sym_dict *dict;
   try(interp_wordlist(interp, wordlist, &dict));
 
+  // Before snapshotting, so a rejected word is rewound like any other.
   try(interp_validate_redefinition(interp, name, wordlist, redef));
-  dict_set(dict, name, sym);
+  try(interp_snapshot(interp));
+  interp_dict_set(dict, sym);
 
   IF_DEBUG({
     eputs("[debug] compiled:");
@@ -274,6 +275,7 @@ static void interp_repr_sym(const Interp *interp, const Sym *sym) {
         "[debug]   clobber:         0b%s\n"
         "[debug]   inp_len:         %d\n"
         "[debug]   out_len:         %d\n"
+        "[debug]   pure:            %s\n"
 #endif
         "[debug]   plain_call:      %s\n"
         "[debug]   has_err:         %s\n"
@@ -297,6 +299,7 @@ static void interp_repr_sym(const Interp *interp, const Sym *sym) {
         uint32_to_bit_str((U32)sym->clobber),
         sym->inp_len,
         sym->out_len,
+        bool_str(sym->pure),
 #endif
         bool_str(sym->plain_call),
         bool_str(sym->has_err),
@@ -460,7 +463,7 @@ Note: ALL intrinsics must have certain fields set the same way:
 
   .type        = SYM_INTRIN
   .name.len    = strlen(.name.buf)
-  .clobber     = ASM_REGS_VOLATILE
+  .clobber     = SYM_CLOBBER_FOREIGN
   .interp_only = true
 
 Repetition is error-prone, so we set these fields in `sym_init_intrin`.
@@ -472,6 +475,20 @@ Some fields are used only in the register-based callvention:
   clobber
 */
 
+/*
+Hidden XT for standard Forth `;`. Used by defining words that push an XT
+for `end` to pop and call. Not listed in `INTRIN` because it's not a part
+of any wordlist; see `interp_init_syms`.
+*/
+static const USED auto INTRIN_SEMICOLON = (Sym){
+  .name.buf  = ";",
+  .wordlist  = WORDLIST_COMP,
+  .intrin    = (void *)intrin_semicolon,
+  .out_len   = 1,
+  .has_err   = true,
+  .comp_only = true,
+};
+
 static const USED auto INTRIN_END = (Sym){
   .name.buf   = "end",
   .wordlist   = WORDLIST_COMP,
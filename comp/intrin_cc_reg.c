@@ -1,6 +1,6 @@
 #pragma once
 #include "./interp_internal.c"
-#include "./mach_o.c"
+#include "./exe.c"
 
 #ifdef CLANGD
 #include "./intrin.c"
@@ -257,7 +257,13 @@ static Err intrin_recur(Interp *interp) {
   */
   try(comp_forget_regs(comp, ASM_REGS_VOLATILE));
   bits_add_all_to(&sym->clobber, ASM_REGS_VOLATILE);
+  try(comp_validate_call_vec_regs(
+    comp, sym->name.buf, ASM_VEC_REGS_SCRATCH << ASM_VEC_CLOBBER_SHIFT
+  ));
+
+  const auto floor = stack_len_valid(&comp->code.code_write);
   try(comp_append_recur(comp));
+  comp_note_tail(comp, sym, floor);
   try(comp_after_append_call(comp, sym, sym, comp->ctx.auto_try));
 
   sym->norm.has_recur = true;
@@ -292,6 +298,25 @@ static Err intrin_interp_only(bool val, Interp *interp) {
   return nullptr;
 }
 
+/*
+Marks the current word as free of side effects, so that calls with constant
+inputs are evaluated at compile time; see `interp_comp_call_pure`. Errors
+would have to be raised at compile time instead, so they're not allowed.
+*/
+static Err intrin_pure(Interp *interp) {
+  Sym *sym;
+  try(interp_require_current_sym(interp, &sym));
+
+  if (sym->has_err) {
+    return errf(
+      "unable to mark " FMT_QUOTED " as pure: pure words can't return errors",
+      sym->name.buf
+    );
+  }
+  sym->pure = true;
+  return nullptr;
+}
+
 /*
 Caution: unlike most Forth systems, because of Apple's W^X restrictions,
 we use two code heaps: writable and executable. Control structures often
@@ -308,15 +333,18 @@ static Err intrin_here_write(Interp *interp, Instr **out) {
 /*
 Returns an address in the executable heap corresponding to the next instruction
 in the writable heap during word compilation. The returned address does NOT yet
-contain a valid instruction, but may be stashed for later use.
+contain a valid instruction, but may be stashed for later use. Since it may be
+stashed, the current word must stay where it is; see `comp_sym_settle`.
 */
 static Err intrin_here_exec(Interp *interp, Instr **out) {
   if (!out) return nullptr;
-  *out = comp_code_next_prog_counter(&interp->comp.code);
+  interp->comp.ctx.pinned = true;
+  *out                    = comp_code_next_prog_counter(&interp->comp.code);
   return nullptr;
 }
 
 static Err intrin_comp_instr(Instr instr, Interp *interp) {
+  try(comp_code_ensure_space(&interp->comp.code));
   asm_append_instr(&interp->comp, instr);
   return nullptr;
 }
@@ -360,7 +388,7 @@ static Err intrin_comp_page_load(Sint adr, Sint reg, Interp *interp) {
 static Err intrin_comp_call(Sint ptr, Interp *interp) {
   Sym *sym;
   try(interp_sym_by_ptr(interp, ptr, &sym));
-  return comp_append_call_sym(&interp->comp, sym);
+  return interp_comp_call_sym(interp, sym);
 }
 
 static Err intrin_read_char(Interp *interp, Sint *out) {
@@ -434,6 +462,38 @@ static Err intrin_extern_fun(
   return nullptr;
 }
 
+/*
+Marks parameters of the most recently declared extern as `F64`. Bit N of
+`inp_mask` corresponds to input N; a non-zero `out_mask` marks the output.
+Floats are passed in FP registers; see `asm_append_call_extern`.
+*/
+static Err intrin_extern_float(Sint inp_mask, Sint out_mask, Interp *interp) {
+  const auto syms = &interp->syms;
+  if (!stack_len(syms) || stack_head(syms).type != SYM_EXTERN) {
+    return err_str("unable to mark extern parameters as floats: no extern");
+  }
+
+  const auto sym = &stack_head(syms);
+  const auto cap = (Sint)1 << sym->inp_len;
+
+  if (inp_mask < 0 || inp_mask >= cap) {
+    return errf(
+      FMT_QUOTED ": float input mask " FMT_SINT " exceeds " FMT_SINT
+      " input parameters",
+      sym->name.buf,
+      inp_mask,
+      (Sint)sym->inp_len
+    );
+  }
+  if (out_mask && !sym->out_len) {
+    return errf(FMT_QUOTED ": no output to mark as float", sym->name.buf);
+  }
+
+  sym->flt_inps = (U8)inp_mask;
+  sym->flt_out  = out_mask != 0;
+  return nullptr;
+}
+
 static Err intrin_find_word(
   Sint buf, Sint len, Wordlist wordlist, Interp *interp, const Sym **sym
 ) {
@@ -566,6 +626,30 @@ static Err intrin_comp_realloc_reg(Sint reg, Interp *interp) {
   return nullptr;
 }
 
+static Err intrin_comp_alloc_vec_reg(Interp *interp, Sint *out) {
+  U8 reg;
+  try(comp_alloc_vec_reg(&interp->comp, &reg));
+  if (out) *out = reg;
+  return nullptr;
+}
+
+static Err intrin_comp_alloc_vec_reg_stable(Interp *interp, Sint *out) {
+  U8 reg;
+  try(comp_alloc_vec_reg_stable(&interp->comp, &reg));
+  if (out) *out = reg;
+  return nullptr;
+}
+
+static Err intrin_comp_free_vec_reg(Sint reg, Interp *interp) {
+  try(comp_validate_vec_reg(reg));
+  return comp_free_vec_reg(&interp->comp, (U8)reg);
+}
+
+static Err intrin_comp_realloc_vec_reg(Sint reg, Interp *interp) {
+  try(comp_validate_vec_reg(reg));
+  return comp_realloc_vec_reg(&interp->comp, (U8)reg);
+}
+
 static Err intrin_comp_local(Sint buf, Sint len, Interp *interp, Local **out) {
   try(interp_validate_buf_len(buf, len));
   return interp_get_local(interp, (const char *)buf, (Ind)len, out);
@@ -602,7 +686,7 @@ static Err intrin_compile_executable(Sint main, Sint path, Interp *interp) {
   try(interp_validate_data_ptr(path));
   Sym *sym;
   try(interp_sym_by_ptr(interp, main, &sym));
-  try(compile_mach_executable_to(interp, (const char *)path, sym));
+  try(compile_executable_to(interp, (const char *)path, sym, false));
   return nullptr;
 }
 
@@ -762,6 +846,24 @@ static const USED auto INTRIN_BRACE = (Sym){
   .comp_only = true,
 };
 
+static const USED auto INTRIN_PURE = (Sym){
+  .name.buf  = ".pure",
+  .wordlist  = WORDLIST_EXEC,
+  .intrin    = (void *)intrin_pure,
+  .out_len   = 1,
+  .has_err   = true,
+  .comp_only = true,
+};
+
+static const USED auto INTRIN_EXTERN_FLOAT = (Sym){
+  .name.buf = ".extern_float",
+  .wordlist = WORDLIST_EXEC,
+  .intrin   = (void *)intrin_extern_float,
+  .inp_len  = 2,
+  .out_len  = 1,
+  .has_err  = true,
+};
+
 static const USED auto INTRIN_COMP_SIGNATURE_GET = (Sym){
   .name.buf  = ".comp_signature_get",
   .wordlist  = WORDLIST_EXEC,
@@ -869,6 +971,44 @@ static const USED auto INTRIN_COMP_REALLOC_REG = (Sym){
   .comp_only = true,
 };
 
+static const USED auto INTRIN_COMP_ALLOC_VEC_REG = (Sym){
+  .name.buf  = ".comp_alloc_vec_reg",
+  .wordlist  = WORDLIST_EXEC,
+  .intrin    = (void *)intrin_comp_alloc_vec_reg,
+  .out_len   = 2,
+  .has_err   = true,
+  .comp_only = true,
+};
+
+static const USED auto INTRIN_COMP_ALLOC_VEC_REG_STABLE = (Sym){
+  .name.buf  = ".comp_alloc_vec_reg_stable",
+  .wordlist  = WORDLIST_EXEC,
+  .intrin    = (void *)intrin_comp_alloc_vec_reg_stable,
+  .out_len   = 2,
+  .has_err   = true,
+  .comp_only = true,
+};
+
+static const USED auto INTRIN_COMP_FREE_VEC_REG = (Sym){
+  .name.buf  = ".comp_free_vec_reg",
+  .wordlist  = WORDLIST_EXEC,
+  .intrin    = (void *)intrin_comp_free_vec_reg,
+  .inp_len   = 1,
+  .out_len   = 1,
+  .has_err   = true,
+  .comp_only = true,
+};
+
+static const USED auto INTRIN_COMP_REALLOC_VEC_REG = (Sym){
+  .name.buf  = ".comp_realloc_vec_reg",
+  .wordlist  = WORDLIST_EXEC,
+  .intrin    = (void *)intrin_comp_realloc_vec_reg,
+  .inp_len   = 1,
+  .out_len   = 1,
+  .has_err   = true,
+  .comp_only = true,
+};
+
 static const USED auto INTRIN_COMP_PUSH_FROM_LOCAL = (Sym){
   .name.buf  = ".comp_push_from_local",
   .wordlist  = WORDLIST_EXEC,
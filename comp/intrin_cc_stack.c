@@ -214,9 +214,11 @@ static Err intrin_here_write(Interp *interp) {
 /*
 Returns an address in the executable heap corresponding to the next instruction
 in the writable heap during word compilation. The returned address does NOT yet
-contain a valid instruction, but may be stashed for later use.
+contain a valid instruction, but may be stashed for later use. Since it may be
+stashed, the current word must stay where it is; see `comp_sym_settle`.
 */
 static Err intrin_here_exec(Interp *interp) {
+  interp->comp.ctx.pinned = true;
   try(cell_stack_push(
     &interp->cells, (Sint)(comp_code_next_prog_counter(&interp->comp.code))
   ));
@@ -226,6 +228,7 @@ static Err intrin_here_exec(Interp *interp) {
 static Err intrin_comp_instr(Interp *interp) {
   Sint val;
   try(cell_stack_pop(&interp->cells, &val));
+  try(comp_code_ensure_space(&interp->comp.code));
   try(asm_append_instr_from_int(&interp->comp, val));
   return nullptr;
 }
@@ -7,6 +7,8 @@
 static const USED Sym INTRIN[] = {
   // Specific to this CC.
   INTRIN_BRACE,                      // {
+  INTRIN_PURE,                       // .pure
+  INTRIN_EXTERN_FLOAT,               // .extern_float
   INTRIN_COMP_SIGNATURE_GET,         // .comp_signature_get
   INTRIN_COMP_SIGNATURE_SET,         // .comp_signature_set
   INTRIN_COMP_ARGS_VALID,            // .comp_args_valid
@@ -17,6 +19,10 @@ static const USED Sym INTRIN[] = {
   INTRIN_COMP_INSTR_DROP,            // .comp_instr_drop
   INTRIN_COMP_ALLOC_NEXT_REG,        // .comp_alloc_next_reg
   INTRIN_COMP_REALLOC_REG,           // .comp_realloc_reg
+  INTRIN_COMP_ALLOC_VEC_REG,         // .comp_alloc_vec_reg
+  INTRIN_COMP_ALLOC_VEC_REG_STABLE,  // .comp_alloc_vec_reg_stable
+  INTRIN_COMP_FREE_VEC_REG,          // .comp_free_vec_reg
+  INTRIN_COMP_REALLOC_VEC_REG,       // .comp_realloc_vec_reg
   INTRIN_COMP_BARRIER,               // .comp_barrier
   INTRIN_COMP_PUSH_FROM_LOCAL,       // .comp_push_from_local
   INTRIN_COMP_POP_INTO_LOCAL,        // .comp_pop_into_local
@@ -0,0 +1,727 @@
+/*
+Linking of JIT-compiled code and data into an AOT executable.
+Used by `./mach_o.c` and `./elf.c`; Arm64 only.
+
+By default, the executable gets the runtime region of the code heap and the
+entire data region, preserving all offsets from the JIT; see `./mach_o.c` for
+why this works. Comptime-only words live in a separate region which is left
+out; see `INSTR_RUNTIME_LEN`. Runtime code which calls comptime words needs
+`--shake`; see `link_whole`. The result still includes every runtime word,
+such as the entire runtime part of `lang.af`, most of which is never called.
+
+With tree shaking (`--shake`), we start at `.main`, walk `Sym.callees`, and
+copy only the reachable words into a compacted text section. Unreferenced
+static data is dropped in the same way. Instructions which use PC-relative
+offsets across words are re-patched:
+
+- `b` / `bl` into another word: retargeted to the word's new location.
+- `adrp` of code, used by long calls: likewise, along with the page offset.
+- `adrp` of data: retargeted to the new data location, along with the page
+  offset in the following `add` / `ldr`, see `asm_append_page_addr`.
+- `adrp` of other sections, such as the GOT: adjusted for the new PC.
+  Those sections keep their location relative to the text section.
+
+Branches within a word don't need patching, because words are moved whole,
+unless `--profile` counters were stripped from the word.
+
+Shaken words don't keep their definition order, which interleaves the words
+used by `.main` with unrelated ones such as error-path helpers from `lang.af`.
+Instead they're laid out in depth-first order of the call graph starting at
+`.main`, so that each word follows its first caller, and the words making up
+one call chain are contiguous. When the build was run with `--profile`, words
+are laid out by the number of calls counted while running the program at
+comptime, hottest first, with the call-graph order breaking ties. See
+`link_order_syms`. The counters themselves are stripped from the copied code,
+along with their data; see `link_collect_counters`. Without shaking, the code
+is emitted as-is, counters included.
+
+Data is tracked at the granularity of `comp_alloc_data` allocations. Forth
+code may also bump the data region directly; such bytes between allocations
+are treated as additional regions. A kept region preserves its offset modulo
+its alignment (but at least 16), so scaled `ldr` offsets remain encodable.
+
+Limitations: code which derives code-relative values at runtime via `adr`,
+such as `indirect:` trampolines, can't be relocated; linking fails. Static
+data must not hold absolute addresses; this is also true without shaking.
+*/
+#pragma once
+#include "../clib/err.h"
+#include "../clib/fmt.h"
+#include "../clib/list.c"
+#include "../clib/mem.c"
+#include "../clib/mem.h"
+#include "../clib/set.c"
+#include "./arch.c"
+#include "./comp.c"
+#include "./interp.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Code and data for an executable. Instruction indexes and data offsets are
+relative to the start of the text section and the data section respectively.
+When shaking, `.instrs` and `.data` point into the owned buffers; otherwise
+they point into `Comp_code`.
+*/
+typedef struct {
+  const Instr *instrs;
+  Ind          instr_len;
+  const U8    *data;
+  Ind          data_len;
+  Ind          main_ind;   // Entry instruction of `.main` in `.instrs`.
+  Buf          own_instrs; // Backing storage for shaken `.instrs`.
+  Buf          own_data;   // Backing storage for shaken `.data`.
+} Link;
+
+static void link_deinit(Link *link) {
+  buf_deinit(&link->own_instrs);
+  buf_deinit(&link->own_data);
+  *link = (Link){};
+}
+
+// A reachable word. Indexes are in `Comp_code.code_exec`, except `.new_floor`.
+typedef struct {
+  const Sym *sym;
+  Ind        floor;
+  Ind        ceil;
+  Ind        new_floor;
+  Ind        rank;  // Position in the call-graph order; see `link_rank_sym`.
+  U64        calls; // From `--profile`; zero otherwise.
+
+  // Range of the word's stripped counters; see `link_collect_counters`.
+  Ind counter_floor;
+  Ind counter_ceil;
+} Link_sym;
+
+// A region of static data. Offsets are in `Comp_code.data`, except `.new_off`.
+typedef struct {
+  Ind  off;
+  Ind  len;
+  Ind  align;
+  Ind  new_off;
+  bool used;
+  bool counter; // Holds a `--profile` counter.
+} Link_region;
+
+typedef list_of(Link_sym)        Link_syms;
+typedef list_of(const Link_sym *) Link_order;
+typedef list_of(Link_region)     Link_regions;
+
+// Offset of `Comp_heap.data` from the code, which is also the PC base.
+static constexpr Uint LINK_DATA_REL = offsetof(Comp_heap, data) -
+  offsetof(Comp_heap, exec.instrs);
+
+static Err err_link_branch(const Sym *sym, Ind ind) {
+  return errf(
+    "unable to link executable: word " FMT_QUOTED
+    " branches to an unreachable instruction at index " FMT_IND
+    "; its callees may be incomplete",
+    sym->name.buf,
+    ind
+  );
+}
+
+static Err err_link_adr(const Sym *sym) {
+  return errf(
+    "unable to link executable: word " FMT_QUOTED
+    " uses `adr`, which can't be relocated; try building without `--shake`",
+    sym->name.buf
+  );
+}
+
+static Err err_link_data(const Sym *sym, Uint off) {
+  return errf(
+    "unable to link executable: word " FMT_QUOTED
+    " references data at offset " FMT_UINT
+    " in an unsupported way; try building without `--shake`",
+    sym->name.buf,
+    off
+  );
+}
+
+static void link_visit(Sym_set *visited, Sym *sym) {
+  if (set_has(visited, sym)) return;
+  set_add(visited, sym);
+
+  for (set_range(Ind, ind, &sym->callees)) {
+    link_visit(visited, sym->callees.vals[ind]);
+  }
+}
+
+static bool link_is_comptime(const Sym *sym) {
+  if (sym->type != SYM_NORM) return false;
+  return instr_region_of(sym->norm.spans.floor) == INSTR_REGION_COMP;
+}
+
+static Err err_link_comptime(const Sym *sym) {
+  return errf(
+    "unable to link executable: runtime code calls word " FMT_QUOTED
+    ", which lives in the comptime region; build with `--shake` to include it",
+    sym->name.buf
+  );
+}
+
+/*
+Emits the runtime region of the code heap. The comptime region follows it at
+`INSTR_RUNTIME_LEN`, so including any of it would require emitting the whole
+unused tail of the runtime region, making the executable hundreds of MiB of
+mostly zeros. Runtime code can reach it by calling words from the comp
+wordlist; such builds are rejected, since `--shake` handles them properly.
+*/
+static Err link_whole(const Comp_code *code, const Sym *main, Link *out) {
+  deferred(set_deinit) Sym_set visited = {};
+  link_visit(&visited, (Sym *)main);
+
+  for (set_range(Ind, ind, &visited)) {
+    const auto sym = visited.vals[ind];
+    if (link_is_comptime(sym)) return err_link_comptime(sym);
+  }
+
+  out->instrs    = code->code_exec.floor;
+  out->instr_len = comp_code_region_lens(code, INSTR_REGION_RUNTIME).exec;
+  out->data      = code->data.floor;
+  out->data_len  = (Ind)stack_len_valid(&code->data);
+  out->main_ind  = main->norm.spans.prologue;
+  return nullptr;
+}
+
+/*
+Reachable words of one instruction region, in the order of their code.
+Within a region, code is laid out in definition order; see `comp_sym_settle`.
+*/
+static Err link_collect_region_syms(
+  const Interp  *interp,
+  const Sym_set *visited,
+  Instr_region   region,
+  Link_syms     *out,
+  Ind           *new_floor
+) {
+  Ind prev_ceil = 0;
+
+  for (stack_range(auto, sym, &interp->syms)) {
+    if (sym->type != SYM_NORM || !set_has(visited, sym)) continue;
+
+    const auto spans = &sym->norm.spans;
+    if (instr_region_of(spans->floor) != region) continue;
+
+    try_assert(spans->floor >= prev_ceil);
+    try_assert(spans->ceil >= spans->floor);
+
+    list_append(
+      out,
+      (Link_sym){
+        .sym       = sym,
+        .floor     = spans->floor,
+        .ceil      = spans->ceil,
+        .new_floor = *new_floor,
+        .rank      = INVALID_IND,
+      }
+    );
+
+    prev_ceil = spans->ceil;
+    *new_floor += spans->ceil - spans->floor;
+  }
+  return nullptr;
+}
+
+// Reachable words in the order of their code: runtime region, then comptime.
+static Err link_collect_syms(
+  const Interp *interp, const Sym *main, Link_syms *out
+) {
+  deferred(set_deinit) Sym_set visited = {};
+  link_visit(&visited, (Sym *)main);
+
+  Ind new_floor = 0;
+  try(link_collect_region_syms(
+    interp, &visited, INSTR_REGION_RUNTIME, out, &new_floor
+  ));
+  try(link_collect_region_syms(
+    interp, &visited, INSTR_REGION_COMP, out, &new_floor
+  ));
+  return nullptr;
+}
+
+// Binary search; `syms` are sorted and don't overlap.
+static const Link_sym *link_find_sym(const Link_syms *syms, Ind ind) {
+  Ind floor = 0;
+  Ind ceil  = syms->len;
+
+  while (floor < ceil) {
+    const auto mid = floor + (ceil - floor) / 2;
+    const auto val = &syms->dat[mid];
+    if (ind < val->floor) ceil = mid;
+    else if (ind >= val->ceil) floor = mid + 1;
+    else return val;
+  }
+  return nullptr;
+}
+
+// The latest counter of a word wins, in case it was redefined in place.
+static U64 link_sym_calls(const Comp *comp, const Sym *sym) {
+  const auto prof = &comp->prof;
+
+  for (auto ind = prof->len; ind > 0; ind--) {
+    const auto counter = &prof->dat[ind - 1];
+    if (counter->sym != sym) continue;
+    return *(const U64 *)(comp->code.data.floor + counter->off);
+  }
+  return 0;
+}
+
+static int link_cmp_floor(const void *one, const void *two) {
+  const auto sym_0 = *(const Link_sym *const *)one;
+  const auto sym_1 = *(const Link_sym *const *)two;
+  return sym_0->floor < sym_1->floor ? -1 : sym_0->floor > sym_1->floor;
+}
+
+static int link_cmp_layout(const void *one, const void *two) {
+  const auto sym_0 = *(const Link_sym *const *)one;
+  const auto sym_1 = *(const Link_sym *const *)two;
+
+  if (sym_0->calls != sym_1->calls) {
+    return sym_0->calls > sym_1->calls ? -1 : 1;
+  }
+  return sym_0->rank < sym_1->rank ? -1 : sym_0->rank > sym_1->rank;
+}
+
+// Length of the word in the executable, without its counters.
+static Ind link_sym_len(const Link_sym *elem) {
+  const auto counters = elem->counter_ceil - elem->counter_floor;
+  return elem->ceil - elem->floor - counters * ASM_COUNTER_INSTR_LEN;
+}
+
+/*
+Index in the executable of the word's instruction at the given index. Indexes
+inside a stripped counter map to the instruction following it.
+*/
+static Ind link_new_ind(
+  const Ind_list *counters, const Link_sym *elem, Ind ind
+) {
+  auto out = elem->new_floor + (ind - elem->floor);
+
+  for (auto pos = elem->counter_floor; pos < elem->counter_ceil; pos++) {
+    const auto start = counters->dat[pos];
+    if (start >= ind) break;
+
+    const auto skip = ind - start;
+    out -= skip < ASM_COUNTER_INSTR_LEN ? skip : ASM_COUNTER_INSTR_LEN;
+  }
+  return out;
+}
+
+/*
+Depth-first preorder over the call graph. Callees are visited in definition
+order, because `Sym.callees` is a hash set whose order is arbitrary. Without
+static call frequencies, this is the simplest order which keeps every call
+chain from `.main` contiguous; a cheap static stand-in for Pettis-Hansen.
+*/
+static void link_rank_sym(Link_syms *syms, Link_sym *elem, Ind *rank) {
+  if (elem->rank != INVALID_IND) return;
+  elem->rank = (*rank)++;
+
+  const auto callees = &elem->sym->callees;
+  deferred(list_deinit) Link_order next = {};
+
+  for (set_range(Ind, ind, callees)) {
+    const auto callee = callees->vals[ind];
+    if (callee->type != SYM_NORM) continue;
+
+    const auto found = link_find_sym(syms, callee->norm.spans.floor);
+    if (found) list_append(&next, found);
+  }
+
+  qsort(next.dat, next.len, sizeof(next.dat[0]), link_cmp_floor);
+
+  for (Ind ind = 0; ind < next.len; ind++) {
+    link_rank_sym(syms, (Link_sym *)next.dat[ind], rank);
+  }
+}
+
+/*
+Determines the order in which words are copied, and reassigns their new
+floors accordingly. `syms` themselves stay sorted by their old floors,
+which is required by `link_find_sym`.
+*/
+static void link_order_syms(
+  const Comp *comp, const Sym *main, Link_syms *syms, Link_order *out
+) {
+  const auto main_elem = link_find_sym(syms, main->norm.spans.floor);
+  Ind        rank      = 0;
+  if (main_elem) link_rank_sym(syms, (Link_sym *)main_elem, &rank);
+
+  for (auto elem = syms->dat; elem < syms->dat + syms->len; elem++) {
+    // Everything is reachable from `.main`; this is just in case.
+    if (elem->rank == INVALID_IND) elem->rank = rank++;
+    elem->calls = link_sym_calls(comp, elem->sym);
+    list_append(out, (const Link_sym *)elem);
+  }
+
+  qsort(out->dat, out->len, sizeof(out->dat[0]), link_cmp_layout);
+
+  Ind new_floor = 0;
+  for (Ind ind = 0; ind < out->len; ind++) {
+    const auto elem = (Link_sym *)out->dat[ind];
+    elem->new_floor = new_floor;
+    new_floor += link_sym_len(elem);
+  }
+}
+
+// Covers the entire data region: recorded allocations and any gaps.
+static void link_collect_regions(const Comp_code *code, Link_regions *out) {
+  const auto data_len = (Ind)stack_len_valid(&code->data);
+  Ind        cursor   = 0;
+
+  for (stack_range(auto, alloc, &code->data_allocs)) {
+    if (alloc->off > cursor) {
+      list_append(
+        out, (Link_region){.off = cursor, .len = alloc->off - cursor, .align = 1}
+      );
+    }
+    list_append(
+      out,
+      (Link_region){.off = alloc->off, .len = alloc->len, .align = alloc->align}
+    );
+    cursor = alloc->off + alloc->len;
+  }
+
+  if (data_len > cursor) {
+    list_append(
+      out, (Link_region){.off = cursor, .len = data_len - cursor, .align = 1}
+    );
+  }
+}
+
+/*
+Finds the last region which begins at or before the offset. Zero-length
+allocations share their offset with the next region, which wins.
+*/
+static Link_region *link_find_region(Link_regions *regions, Uint off) {
+  Ind floor = 0;
+  Ind ceil  = regions->len;
+
+  while (floor < ceil) {
+    const auto mid = floor + (ceil - floor) / 2;
+    if (regions->dat[mid].off <= off) floor = mid + 1;
+    else ceil = mid;
+  }
+  if (!floor) return nullptr;
+
+  const auto out = &regions->dat[floor - 1];
+  return off < (Uint)out->off + out->len ? out : nullptr;
+}
+
+/*
+If the instruction at the given index is `adrp` followed by a page offset,
+together referencing static data, outputs the data offset. The address may
+also reference other sections, in which case this returns false.
+*/
+static bool link_data_ref(
+  const Instr *instrs, const Link_sym *elem, Ind ind, Uint data_len, Uint *out
+) {
+  const auto instr = instrs[ind];
+  if ((instr & ASM_MASK_ADR) != ASM_BASE_ADRP) return false;
+  if (ind + 1 >= elem->ceil) return false;
+
+  Uint pageoff;
+  if (!asm_decode_pageoff(instrs[ind + 1], asm_decode_reg_0(instr), &pageoff)) {
+    return false;
+  }
+
+  const auto adr = asm_decode_adrp_page(instr, ind) + (Sint)pageoff;
+
+  if (adr < (Sint)LINK_DATA_REL) return false;
+  if (adr >= (Sint)(LINK_DATA_REL + data_len)) return false;
+  *out = (Uint)adr - LINK_DATA_REL;
+  return true;
+}
+
+/*
+Like `link_data_ref`, but for `adrp` with a page offset which together address
+an instruction, such as a long call, see `asm_append_call_norm`. Outputs the
+index of the instruction.
+*/
+static bool link_code_ref(
+  const Instr *instrs, const Link_sym *elem, Ind ind, Ind *out
+) {
+  const auto instr = instrs[ind];
+  if ((instr & ASM_MASK_ADR) != ASM_BASE_ADRP) return false;
+  if (ind + 1 >= elem->ceil) return false;
+
+  Uint pageoff;
+  if (!asm_decode_pageoff(instrs[ind + 1], asm_decode_reg_0(instr), &pageoff)) {
+    return false;
+  }
+
+  const auto adr = asm_decode_adrp_page(instr, ind) + (Sint)pageoff;
+
+  if (adr < 0 || adr >= (Sint)(INSTR_HEAP_LEN * sizeof(Instr))) return false;
+  if ((Uint)adr % sizeof(Instr)) return false;
+  *out = (Ind)((Uint)adr / sizeof(Instr));
+  return true;
+}
+
+/*
+Finds the `--profile` counter increments in reachable words, including copies
+inlined into other words; see `comp_profile_sym`. The counts are only needed
+at comptime for ordering the layout, so `link_copy_sym` strips the counters,
+and their data regions are dropped like any other unreferenced data. Each
+counter is recognized by its instruction sequence, and by addressing a data
+region allocated for a counter. Outputs sorted instruction indexes.
+*/
+static void link_collect_counters(
+  const Comp   *comp,
+  Link_syms    *syms,
+  Link_regions *regions,
+  Ind_list     *out
+) {
+  const auto code     = &comp->code;
+  const auto instrs   = code->code_exec.floor;
+  const auto data_len = (Uint)stack_len_valid(&code->data);
+  const auto prof     = &comp->prof;
+
+  for (Ind ind = 0; ind < prof->len; ind++) {
+    const auto region = link_find_region(regions, prof->dat[ind].off);
+    if (region) region->counter = true;
+  }
+
+  for (auto elem = syms->dat; elem < syms->dat + syms->len; elem++) {
+    const auto data = elem->sym->norm.spans.data;
+
+    elem->counter_floor = out->len;
+
+    for (Ind ind = elem->floor; ind + ASM_COUNTER_INSTR_LEN <= data; ind++) {
+      Uint off;
+      if (!link_data_ref(instrs, elem, ind, data_len, &off)) continue;
+
+      const auto region = link_find_region(regions, off);
+      if (!region || !region->counter) continue;
+      if (!asm_is_counter_inc(&instrs[ind])) continue;
+
+      list_append(out, ind);
+      ind += ASM_COUNTER_INSTR_LEN - 1;
+    }
+    elem->counter_ceil = out->len;
+  }
+}
+
+/*
+Marks the data regions referenced by reachable words and assigns new offsets.
+Stripped counters don't count as references.
+*/
+static Err link_layout_data(
+  const Comp_code *code,
+  const Link_syms *syms,
+  const Ind_list  *counters,
+  Link_regions    *regions
+) {
+  const auto instrs   = code->code_exec.floor;
+  const auto data_len = (Uint)stack_len_valid(&code->data);
+
+  for (auto elem = syms->dat; elem < syms->dat + syms->len; elem++) {
+    auto pos = elem->counter_floor;
+
+    for (Ind ind = elem->floor; ind < elem->ceil; ind++) {
+      if (pos < elem->counter_ceil && counters->dat[pos] == ind) {
+        ind += ASM_COUNTER_INSTR_LEN - 1;
+        pos++;
+        continue;
+      }
+
+      Uint off;
+      if (!link_data_ref(instrs, elem, ind, data_len, &off)) continue;
+
+      const auto region = link_find_region(regions, off);
+      if (!region) return err_link_data(elem->sym, off);
+      region->used = true;
+    }
+  }
+
+  Ind cursor = 0;
+  for (auto region = regions->dat; region < regions->dat + regions->len;
+       region++) {
+    if (!region->used) continue;
+
+    const auto mod  = region->align > 16 ? region->align : (Ind)16;
+    region->new_off = cursor + ((region->off - cursor) & (mod - 1));
+    cursor          = region->new_off + region->len;
+  }
+  return nullptr;
+}
+
+/*
+Copies the word, skipping its counters. Branches within the word are
+re-encoded only when counters were stripped between them and their targets.
+Instructions in the word's data are copied verbatim.
+*/
+static Err link_copy_sym(
+  const Comp_code *code,
+  const Link_syms *syms,
+  const Ind_list  *counters,
+  Link_regions    *regions,
+  const Link_sym  *elem,
+  Buf             *out
+) {
+  const auto instrs   = code->code_exec.floor;
+  const auto data_len = (Uint)stack_len_valid(&code->data);
+  const auto data     = elem->sym->norm.spans.data;
+  auto       pos      = elem->counter_floor;
+
+  for (Ind ind = elem->floor; ind < elem->ceil; ind++) {
+    const auto instr = instrs[ind];
+
+    if (ind >= data) {
+      buf_append(out, instr);
+      continue;
+    }
+
+    if (pos < elem->counter_ceil && counters->dat[pos] == ind) {
+      ind += ASM_COUNTER_INSTR_LEN - 1;
+      pos++;
+      continue;
+    }
+
+    const auto new_ind = link_new_ind(counters, elem, ind);
+    const auto new_pc  = (Uint)new_ind * sizeof(Instr);
+
+    Sint pc_off;
+    if (asm_decode_short_pc_off(instr, &pc_off)) {
+      const auto tar = (Ind)((Sint)ind + pc_off);
+      const auto off = (Sint)link_new_ind(counters, elem, tar) - (Sint)new_ind;
+      buf_append(out, asm_encode_short_pc_off(instr, off));
+      continue;
+    }
+
+    if ((instr & ASM_MASK_BRANCH_IMM26) == ASM_BASE_BRANCH_IMM26) {
+      const auto tar = (Ind)((Sint)ind + asm_decode_branch_imm26(instr));
+      const auto own = tar >= elem->floor && tar < elem->ceil;
+
+      const auto callee = own ? elem : link_find_sym(syms, tar);
+      if (!callee) return err_link_branch(elem->sym, tar);
+
+      const auto new_tar = link_new_ind(counters, callee, tar);
+      const auto off     = (Sint)new_tar - (Sint)new_ind;
+
+      buf_append(
+        out,
+        (instr & ASM_MASK_BRANCH_LINK) ? asm_instr_branch_link_to_offset(off)
+                                       : asm_instr_branch_to_offset(off)
+      );
+      continue;
+    }
+
+    if ((instr & ASM_MASK_ADR) == ASM_BASE_ADR) return err_link_adr(elem->sym);
+    if ((instr & ASM_MASK_ADR) != ASM_BASE_ADRP) {
+      buf_append(out, instr);
+      continue;
+    }
+
+    const auto reg = asm_decode_reg_0(instr);
+    Uint       off;
+    Ind        tar;
+
+    if (link_code_ref(instrs, elem, ind, &tar)) {
+      const auto callee = link_find_sym(syms, tar);
+      if (!callee) return err_link_branch(elem->sym, tar);
+
+      const auto new_tar = link_new_ind(counters, callee, tar);
+      const auto new_adr = (Uint)new_tar * sizeof(Instr);
+
+      U16 pageoff;
+      buf_append(out, asm_instr_adrp(reg, new_pc, new_adr, &pageoff));
+      buf_append(out, asm_encode_pageoff(instrs[ind + 1], pageoff));
+      ind++;
+      continue;
+    }
+
+    if (link_data_ref(instrs, elem, ind, data_len, &off)) {
+      const auto region  = link_find_region(regions, off);
+      const auto new_off = region->new_off + (off - region->off);
+      const auto new_adr = LINK_DATA_REL + new_off;
+
+      U16 pageoff;
+      buf_append(out, asm_instr_adrp(reg, new_pc, new_adr, &pageoff));
+      buf_append(out, asm_encode_pageoff(instrs[ind + 1], pageoff));
+      ind++;
+      continue;
+    }
+
+    const auto page = asm_decode_adrp_page(instr, ind);
+
+    // A bare `adrp` into data would need a page offset we can't insert.
+    if (page >= (Sint)LINK_DATA_REL &&
+        page < (Sint)(LINK_DATA_REL + data_len)) {
+      return err_link_data(elem->sym, (Uint)page - LINK_DATA_REL);
+    }
+
+    buf_append(out, asm_instr_adrp(reg, new_pc, (Uint)page, nullptr));
+  }
+  return nullptr;
+}
+
+static Err link_shaken(const Interp *interp, const Sym *main, Link *out) {
+  const auto code = &interp->comp.code;
+
+  deferred(list_deinit) Link_syms    syms     = {};
+  deferred(list_deinit) Link_order   order    = {};
+  deferred(list_deinit) Link_regions regions  = {};
+  deferred(list_deinit) Ind_list     counters = {};
+
+  try(link_collect_syms(interp, main, &syms));
+  link_collect_regions(code, &regions);
+  link_collect_counters(&interp->comp, &syms, &regions, &counters);
+  link_order_syms(&interp->comp, main, &syms, &order);
+  try(link_layout_data(code, &syms, &counters, &regions));
+
+  for (Ind ind = 0; ind < order.len; ind++) {
+    try(link_copy_sym(
+      code, &syms, &counters, &regions, order.dat[ind], &out->own_instrs
+    ));
+  }
+
+  for (auto region = regions.dat; region < regions.dat + regions.len;
+       region++) {
+    if (!region->used) continue;
+    buf_zeropad_to(&out->own_data, region->new_off);
+    buf_append_bytes(
+      &out->own_data, code->data.floor + region->off, region->len
+    );
+  }
+
+  const auto main_elem = link_find_sym(&syms, main->norm.spans.prologue);
+  try_assert(main_elem && main_elem->sym == main);
+
+  out->instrs    = (const Instr *)out->own_instrs.dat;
+  out->instr_len = out->own_instrs.len / (Ind)sizeof(Instr);
+  out->data      = out->own_data.dat;
+  out->data_len  = out->own_data.len;
+  out->main_ind  = link_new_ind(
+    &counters, main_elem, main->norm.spans.prologue
+  );
+  return nullptr;
+}
+
+/*
+Prepares code and data for writing into an executable.
+The caller must sync the code and validate `.main` first.
+*/
+static Err link_executable(
+  const Interp *interp, const Sym *main, bool shake, Link *out
+) {
+  const auto code = &interp->comp.code;
+  *out            = (Link){};
+
+  if (!shake) return link_whole(code, main, out);
+
+  try(link_shaken(interp, main, out));
+
+  eprintf(
+    "[build] tree shaking: text: " FMT_IND " -> " FMT_IND
+    " bytes; data: " FMT_IND " -> " FMT_IND " bytes\n",
+    (Ind)(comp_code_region_lens(code, INSTR_REGION_RUNTIME).exec *
+          sizeof(Instr)),
+    (Ind)(out->instr_len * sizeof(Instr)),
+    (Ind)stack_len_valid(&code->data),
+    out->data_len
+  );
+  return nullptr;
+}
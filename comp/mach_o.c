@@ -26,31 +26,12 @@ but stack-CC still lacks the needed runtime setup.
 #include "./arch.c"
 #include "./comp.c"
 #include "./interp.h"
+#include "./link.c"
 #include <mach/shared_region.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
-static Err err_sym_interp_only(const Sym *sym, const Sym *dep) {
-  return errf(
-    "unable to compile: symbol " FMT_QUOTED " used by " FMT_QUOTED
-    " is interpreter-only",
-    dep->name.buf,
-    sym->name.buf
-  );
-}
-
-static Err validate_callees_can_compile(Sym_set *visited, const Sym *sym) {
-  for (set_range(Ind, ind, &sym->callees)) {
-    const auto dep = sym->callees.vals[ind];
-    if (set_has(visited, dep)) continue;
-    set_add(visited, dep);
-    if (dep->interp_only) return err_sym_interp_only(sym, dep);
-    try(validate_callees_can_compile(visited, dep));
-  }
-  return nullptr;
-}
-
 static void encode_got_section(const Comp *comp, Buf *buf) {
   const auto cap = stack_len_valid(&comp->code.externs.addrs);
 
@@ -164,7 +145,9 @@ static void encode_linkedit_section(
   }
 }
 
-static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
+static Err compile_mach_executable(
+  Interp *interp, Buf *buf, const Sym *main, bool shake
+) {
   try(comp_validate_main(main));
 
   const auto comp = &interp->comp;
@@ -176,6 +159,9 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
     try(validate_callees_can_compile(&visited, main));
   }
 
+  deferred(link_deinit) Link link = {};
+  try(link_executable(interp, main, shake, &link));
+
   /*
   We build the image piece-by-piece, but some of the sizes and offsets have to
   be calculated in advance because they're specified in the header structs.
@@ -255,8 +241,7 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
   constexpr U32 text_code_file_off = mem_align_page(sizeof(Mach_head) + cmd_size);
   constexpr U64 text_code_vm_off = text_seg_vm_off + text_code_file_off;
 
-  const auto instrs              = &code->code_exec;
-  const U32  text_code_real_size = stack_len_valid(instrs) * sizeof(Instr);
+  const U32 text_code_real_size = link.instr_len * sizeof(Instr);
 
   const U32 text_seg_size = mem_align_page(
     text_code_file_off + text_code_real_size
@@ -299,7 +284,7 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
   U32 file_off = text_seg_size;
 
   const auto data_file_off  = file_off;
-  const auto data_real_size = stack_len_valid(&code->data);
+  const auto data_real_size = link.data_len;
   const auto data_file_size = mem_align_page(data_real_size);
   const auto data_vm_size   = data_file_size;
 
@@ -546,7 +531,7 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
   );
 
   {
-    const auto main_code_off = main->norm.spans.prologue * sizeof(Instr);
+    const auto main_code_off = link.main_ind * sizeof(Instr);
     const auto main_off      = text_code_file_off + main_code_off;
 
     buf_append(
@@ -593,16 +578,16 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
   buf_zeropad_to(buf, text_code_file_off);
   try_assert(buf->len == text_code_file_off);
 
-  try_assert(text_code_real_size == stack_len_valid(instrs) * sizeof(Instr));
-  buf_append_bytes(buf, (const U8 *)instrs->floor, text_code_real_size);
+  try_assert(text_code_real_size == link.instr_len * sizeof(Instr));
+  buf_append_bytes(buf, (const U8 *)link.instrs, text_code_real_size);
   try_assert(buf->len == text_code_file_off + text_code_real_size);
 
   try_assert(buf->len <= data_file_off);
   buf_zeropad_to(buf, data_file_off);
   try_assert(buf->len == data_file_off);
 
-  try_assert(data_real_size == stack_len_valid(&code->data));
-  buf_append_bytes(buf, code->data.floor, data_real_size);
+  try_assert(data_real_size == link.data_len);
+  buf_append_bytes(buf, link.data, data_real_size);
   try_assert(buf->len == data_file_off + data_real_size);
 
   try_assert(buf->len <= got_file_off);
@@ -638,10 +623,10 @@ static Err compile_mach_executable(Interp *interp, Buf *buf, const Sym *main) {
 }
 
 static Err compile_mach_executable_to(
-  Interp *interp, const char *path, const Sym *main
+  Interp *interp, const char *path, const Sym *main, bool shake
 ) {
   deferred(buf_deinit) Buf buf = {};
-  try(compile_mach_executable(interp, &buf, main));
+  try(compile_mach_executable(interp, &buf, main, shake));
 
   // The following code could have just used deferred deinit,
   // but clang-analyzer explodes with false positives.
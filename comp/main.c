@@ -1,9 +1,15 @@
 #include "../clib/cli.c"
 #include "../clib/err.h"
 #include "../clib/time.c"
+#include "./exe.c"
+#include "./image.c"
 #include "./interp.c"
+#ifdef __APPLE__
 #include "./mach_exc.c"
-#include "./mach_o.c"
+#else
+#include "./sig_exc.c"
+#endif
+
 #include <stdio.h>
 #include <string.h>
 
@@ -27,9 +33,17 @@ static void print_help() {
     "Flags:\n"
     "\n"
 #ifndef CALL_CONV_STACK
-    "  --build  -- AOT-compile a Mach-O executable\n"
+    "  --build  -- AOT-compile a native executable (Mach-O or ELF)\n"
+    "  --shake  -- in `--build`, drop code and data unreachable from `.main`\n"
     "  --slop   -- disable sloppy-code diagnostics\n"
 #endif // CALL_CONV_STACK
+    "  --opt    -- Arm64: drop no-op instructions from compiled words,\n"
+    "              call externs via per-word stubs\n"
+    "  --profile -- count calls of each subsequently compiled word;\n"
+    "               `--shake` then lays out the hottest words first\n"
+    "               and strips the counters from the executable\n"
+    "  --save-image -- save interpreter state to a file\n"
+    "  --load-image -- replace interpreter state from a file\n"
     "  --debug  -- extremely verbose debug logging\n"
     "  --trace  -- enable C stack traces on errors\n"
     "  --timing -- print per-import execution time\n"
@@ -41,6 +55,8 @@ static void print_help() {
 #ifndef CALL_CONV_STACK
     "  SLOP   -- same as `--slop`\n"
 #endif // CALL_CONV_STACK
+    "  OPT    -- same as `--opt`\n"
+    "  PROFILE -- same as `--profile`\n"
     "  TRACE  -- same as `--trace`\n"
     "  TIMING -- same as `--timing`\n"
     "\n"
@@ -48,10 +64,16 @@ static void print_help() {
     "Every file is evaluated immediately.\n"
     "Flags take effect only when reached.)\n"
     "\n"
+    "Skipping bootstrap via images (same executable only):\n"
+    "\n"
+    "  astil lang.af --save-image=lang.img\n"
+    "  astil --load-image=lang.img <file0> <file1> ...\n"
+    "\n"
 #ifndef CALL_CONV_STACK
     "Compiling to a native executable:\n"
     "\n"
     "  astil <file> --build=out.exe\n"
+    "  astil <file> --shake --build=out.exe\n"
     "  ./out.exe\n"
     "\n"
 #endif // CALL_CONV_STACK
@@ -63,7 +85,7 @@ static void print_help() {
   );
 }
 
-static Err build(Interp *interp, const char *path) {
+static Err build(Interp *interp, const char *path, bool shake) {
   if (!path || !path[0]) {
     return err_str("unable to build executable: missing output path");
   }
@@ -73,12 +95,13 @@ static Err build(Interp *interp, const char *path) {
     return err_str("unable to build executable: missing entry point `.main`");
   }
 
-  try(compile_mach_executable_to(interp, path, sym));
+  try(compile_executable_to(interp, path, sym, shake));
   return nullptr;
 }
 
 static Err main_run(int argc, const char *argv[]) {
   bool timing = false;
+  bool shake  = false;
   try(env_bool("DEBUG", &DEBUG));
   try(env_bool("TRACE", &TRACE));
   try(env_bool("timing", &timing));
@@ -89,6 +112,8 @@ static Err main_run(int argc, const char *argv[]) {
   interp.argv = argv;
 
   try(env_bool("SLOP", &interp.slop));
+  try(env_bool("OPT", &interp.comp.opt));
+  try(env_bool("PROFILE", &interp.comp.profile));
   try(init_exception_handling());
 
   const auto ceil = argv + argc;
@@ -123,6 +148,26 @@ static Err main_run(int argc, const char *argv[]) {
       continue;
     }
 
+    if (!strcmp(key, "--save-image")) {
+      Timing time = {.prefix = "[save_image] "};
+      if (timing) timing_beg(&time);
+
+      try(interp_save_image(&interp, val));
+
+      if (timing) timing_end(&time);
+      continue;
+    }
+
+    if (!strcmp(key, "--load-image")) {
+      Timing time = {.prefix = "[load_image] "};
+      if (timing) timing_beg(&time);
+
+      try(interp_load_image(&interp, val));
+
+      if (timing) timing_end(&time);
+      continue;
+    }
+
     // Conventional args terminator. The program is free to use the rest.
     if (!strcmp(key, "--")) break;
 
@@ -134,12 +179,23 @@ static Err main_run(int argc, const char *argv[]) {
     try(cli_bool_for("--slop", key, val, &interp.slop, &ok));
     if (ok) continue;
 
+    try(cli_bool_for("--opt", key, val, &interp.comp.opt, &ok));
+    if (ok) continue;
+
+    try(cli_bool_for("--profile", key, val, &interp.comp.profile, &ok));
+    if (ok) continue;
+
     try(cli_bool_for("--trace", key, val, &TRACE, &ok));
     if (ok) continue;
 
     try(cli_bool_for("--timing", key, val, &timing, &ok));
     if (ok) continue;
 
+#ifndef CALL_CONV_STACK
+    try(cli_bool_for("--shake", key, val, &shake, &ok));
+    if (ok) continue;
+#endif // CALL_CONV_STACK
+
     {
       bool help;
       try(cli_bool_for("--help", key, val, &help, &ok));
@@ -154,7 +210,7 @@ static Err main_run(int argc, const char *argv[]) {
       Timing time = {.prefix = "[build] "};
       if (timing) timing_beg(&time);
 
-      try(build(&interp, val));
+      try(build(&interp, val, shake));
 
       if (timing) timing_end(&time);
       continue;
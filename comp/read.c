@@ -5,6 +5,8 @@
 #include "../clib/mem.h"
 #include "./read_char.c"
 #include <execinfo.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 static bool reader_valid(const Reader *read) {
@@ -15,33 +17,60 @@ static bool reader_has_more(const Reader *read) {
   return read->pos < read->len;
 }
 
-static Read_pos reader_pos(const Reader *read) {
-  Read_pos pos = {
-    .ind = read ? read->pos : 0,
-    .row = 1,
-    .col = 1,
-  };
-
-  if (!reader_valid(read)) return pos;
-
-  U8 last = 0;
-  for (Ind ind = 0; ind < read->pos && ind < read->len; ind++) {
-    const auto next = (U8)read->src[ind];
-    if ((next == '\n' && last != '\r') || last == '\r') {
+static constexpr Read_pos READ_POS_START = {.row = 1, .col = 1};
+
+// Advances `pos` up to `ceil`, counting rows and columns on the way.
+static Read_pos reader_pos_from(const Reader *read, Read_pos pos, Ind ceil) {
+  if (ceil > read->len) ceil = read->len;
+
+  for (; pos.ind < ceil; pos.ind++) {
+    const auto next = (U8)read->src[pos.ind];
+    if ((next == '\n' && pos.last != '\r') || pos.last == '\r') {
       pos.row++;
       pos.col = 1;
     }
     else {
       pos.col++;
     }
-    last = next;
+    pos.last = next;
   }
+  return pos;
+}
 
+/*
+Resumes from `Reader.mark` when possible, so that resolving successive
+positions in one source is linear overall rather than quadratic. Only
+rereading a word moves the position backwards, which needs a full rescan.
+*/
+static Read_pos reader_pos_near(const Reader *read) {
+  const auto mark = read->mark;
+  const auto from = mark.row && mark.ind <= read->pos ? mark : READ_POS_START;
+  return reader_pos_from(read, from, read->pos);
+}
+
+/*
+Doesn't update the mark, so it's usable on const readers and in signal
+handlers. See `reader_mark`.
+*/
+static Read_pos reader_pos(const Reader *read) {
+  if (!reader_valid(read)) {
+    auto pos = READ_POS_START;
+    pos.ind  = read ? read->pos : 0;
+    return pos;
+  }
+
+  auto pos = reader_pos_near(read);
+  pos.ind  = read->pos;
   return pos;
 }
 
+static void reader_mark(Reader *read) {
+  if (reader_valid(read)) read->mark = reader_pos_near(read);
+}
+
 static Err reader_err(Reader *read, Err err) {
   if (!err || !reader_valid(read) || !read->pos) return err;
+  reader_mark(read);
 
   return err_wrapf(
     "%s\n"
@@ -131,6 +160,36 @@ static Err err_radix_prefix_no_digit(const char *src, Ind len) {
   return errf("unexpected bare `%.*s`; requires at least one digit", len, src);
 }
 
+static Err err_num_float(const char *src, Ind len) {
+  return errf("malformed floating point literal `%.*s`", len, src);
+}
+
+/*
+Parses the whitespace-delimited token starting at `beg` as an `F64`,
+and outputs its bit pattern, which is how floats are kept in cells.
+*/
+static Err read_num_float(Reader *read, Ind beg, Sint *out) {
+  auto end = read->pos;
+  while (char_to_digit(read_char_at(read, end)) != DIGIT_BREAK) end++;
+
+  const auto src = read->src + beg;
+  const auto len = end - beg;
+  char       buf[64];
+
+  if (len >= sizeof(buf)) return err_num_float(src, len);
+  memcpy(buf, src, len);
+  buf[len] = 0;
+
+  char      *tail;
+  const auto val = strtod(buf, &tail);
+  if (tail != buf + len || !isfinite(val)) return err_num_float(src, len);
+
+  static_assert(sizeof(val) == sizeof(*out));
+  memcpy(out, &val, sizeof(*out));
+  read->pos = end;
+  return nullptr;
+}
+
 /*
 Supported formats:
 
@@ -138,11 +197,15 @@ Supported formats:
 - Octal:   0o123467
 - Decimal: 123 +234 -345
 - Hex:     0x123456789abcdef
+- Float:   1.5 -0.25 6.02e23
 
 Binary, octal, and hex are treated as unsigned during parsing,
 and the preceding minus is forbidden for them, as it's unclear
 what its semantics should be: either `~num + 1` as with signed
 multiplication by -1, or simply set the sign bit to 1.
+
+Decimals containing a dot are parsed as `F64`; the output is the
+bit pattern of the float. Group separators aren't supported there.
 */
 static Err read_num(Reader *read, Sint *out) {
   const auto beg  = read->pos;
@@ -205,7 +268,10 @@ static Err read_num(Reader *read, Sint *out) {
       case DIGIT_BREAK: goto done;
 
       // Numeric syntax owns the whole whitespace-delimited token.
-      case DIGIT_INVALID: return err_num_not_terminated(head);
+      case DIGIT_INVALID: {
+        if (is_signed && head == '.') return read_num_float(read, beg, out);
+        return err_num_not_terminated(head);
+      }
 
       default: {
         if (is_signed && dig >= 10) {
@@ -316,3 +382,41 @@ static Err read_until_char(
   if (out_len) *out_len = read->pos - beg;
   return nullptr;
 }
+
+/*
+#include "../clib/err.h"
+
+// Positions resumed from a mark must match full rescans, including marks
+// which fall between `\r` and `\n`, where only `Read_pos.last` tells
+// whether the `\n` starts another line.
+int main() {
+  static constexpr char src[] = "one\r\ntwo\rthree\nfour\r\n\r\nfive";
+  Reader read = {.src = src, .len = sizeof(src) - 1, .path = "<test>"};
+
+  for (Ind mark = 0; mark <= read.len; mark++) {
+    for (Ind pos = mark; pos <= read.len; pos++) {
+      read.mark = (Read_pos){};
+      read.pos  = pos;
+      const auto full = reader_pos(&read);
+
+      read.pos = mark;
+      reader_mark(&read);
+      assert_fatal(read.mark.ind == mark);
+
+      read.pos        = pos;
+      const auto near = reader_pos(&read);
+      assert_fatal(near.row == full.row);
+      assert_fatal(near.col == full.col);
+    }
+  }
+
+  read.pos = 4; // Between `\r` and `\n` of the first line break.
+  reader_mark(&read);
+  assert_fatal(read.mark.last == '\r');
+  assert_fatal(read.mark.row == 1);
+
+  read.pos = read.len;
+  assert_fatal(reader_pos(&read).row == 6);
+  assert_fatal(reader_pos(&read).col == 5);
+}
+*/
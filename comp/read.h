@@ -9,6 +9,7 @@ typedef struct {
   Ind ind;
   Ind row;
   Ind col;
+  U8  last; // Char before `.ind`; resuming from here needs it for CRLF.
 } Read_pos;
 
 // SYNC[interp_reader_fields].
@@ -18,10 +19,15 @@ typedef struct {
   Ind         pos;
   const char *path;
   bool        tty;
+  Read_pos    mark; // Last position resolved by `reader_mark`; 0 = unset.
 } Reader;
 
 #define READ_POS_FMT "%s:" FMT_IND ":" FMT_IND
 
-// TODO avoid double parsing.
+/*
+`reader_pos` resumes from `Reader.mark`, so after `reader_mark` (which
+`reader_err` and the call tracing in `interp_call_norm` do), evaluating
+it twice here only scans from the mark.
+*/
 #define READ_POS_ARGS(read) \
   (read)->path, reader_pos(read).row, reader_pos(read).col
@@ -0,0 +1,167 @@
+/*
+This file implements a signal handler for "bad memory access" faults on
+non-Darwin systems such as Linux; it's the counterpart of `./mach_exc.c`,
+see its description for the general idea.
+
+The handler classifies the faulting address against the guard pages of
+`Comp_heap`, augmenting cryptic segmentation faults with an actual error
+message, such as cell stack underflow or overflow. It then restores the
+default disposition and lets the fault recur, terminating the process.
+
+The handler runs on the faulting thread, on its alternate signal stack (see
+`../clib/sig_exc.c`), and must not allocate or use stdio. All logging goes
+through the `sig_write_*` functions. Threads spawned by Forth code get their
+own alternate stacks, because `find_extern` substitutes `pthread_create`.
+
+Unlike the Mach handler, this doesn't unwind Forth frames in stack-CC: its
+trampoline `asm_call_forth` is currently Darwin-only.
+*/
+#pragma once
+#include "../clib/sig_exc.c"
+#include "../clib/cli.c"
+#include "../clib/misc.h"
+#include "./arch.h"
+#include "./interp.c"
+#include <signal.h>
+#include <ucontext.h>
+
+#define SYS_REC_FMT "[system] [recovery] "
+
+#define ptr_within(ptr, arr)                  \
+  ((const void *)(ptr) >= (const void *)(arr) && \
+   (const void *)(ptr) < (const void *)arr_ceil(arr))
+
+/*
+Each guard page borders a section of `Comp_heap`, in the order given by its
+definition; faulting in a guard means running off the end of the preceding
+section. The cell stack is special: it has guards on both sides, and the one
+below the floor is considered underflow. Returns nil for other addresses.
+
+SYNC[instr_heap_fields].
+*/
+static const char *comp_heap_guard_desc(const Interp *interp, const void *addr) {
+  const auto heap  = interp->comp.code.heap;
+  const auto cells = &interp->cells;
+
+  if (ptr_within(addr, heap->exec.guard_0)) return "instruction heap underflow";
+  if (ptr_within(addr, heap->exec.guard_1)) return "instruction heap overflow";
+  if (ptr_within(addr, heap->guard_0)) return "data section overflow";
+  if (ptr_within(addr, heap->guard_1)) return "extern symbol table overflow";
+  if (ptr_within(addr, heap->guard_2)) return "intrinsic table overflow";
+
+  if (
+    addr >= (const void *)heap->guard_3 &&
+    addr < (const void *)arr_ceil(heap->guard_4)
+  ) {
+    const auto under = addr < (const void *)cells->floor;
+    return under ? "cell stack underflow" : "cell stack overflow";
+  }
+  return nullptr;
+}
+
+static void sig_write_range(
+  const char *prefix, const void *floor, const void *ceil
+) {
+  sig_write_str(prefix);
+  sig_write_str("[");
+  sig_write_ptr(floor);
+  sig_write_str(",");
+  sig_write_ptr(ceil);
+  sig_write_str(")\n");
+}
+
+static void sig_recovery_log_ctx(const Interp *interp) {
+  const auto read = interp_reader_const(interp);
+  if (!reader_valid(read)) return;
+
+  const auto pos = reader_pos(read);
+  sig_write_str(SYS_REC_FMT "position: ");
+  sig_write_str(read->path);
+  sig_write_str(":");
+  sig_write_uint(pos.row, 10);
+  sig_write_str(":");
+  sig_write_uint(pos.col, 10);
+  sig_write_str("\n");
+}
+
+static void sig_on_bad_access(int sig, siginfo_t *info, void *uctx) {
+  (void)info;
+
+  const auto mctx     = &((ucontext_t *)uctx)->uc_mcontext;
+  const auto bad_addr = (const void *)mctx->fault_address;
+  const auto ctx      = (Ctx *)mctx->regs[ASM_REG_CTX];
+
+  if (DEBUG) {
+    sig_write_str(SYS_REC_FMT "signal: ");
+    sig_write_uint((U64)sig, 10);
+    sig_write_str("\n" SYS_REC_FMT "bad address: ");
+    sig_write_ptr(bad_addr);
+    sig_write_str("\n" SYS_REC_FMT "program counter: ");
+    sig_write_ptr((const void *)mctx->pc);
+    sig_write_str("\n" SYS_REC_FMT "context address: ");
+    sig_write_ptr(ctx);
+    sig_write_str("\n");
+  }
+
+  if (!interp_valid((Interp *)ctx)) {
+    if (DEBUG) {
+      sig_write_str(SYS_REC_FMT "address ");
+      sig_write_ptr(ctx);
+      sig_write_str(
+        " recovered from the context register does not appear to reference valid interpreter state\n"
+      );
+    }
+    sig_exception_fallback(sig);
+    return;
+  }
+
+  const auto interp = (const Interp *)ctx;
+  const auto code   = &interp->comp.code;
+  const auto msg    = comp_heap_guard_desc(interp, bad_addr);
+
+  if (!msg) {
+    sig_write_str(SYS_REC_FMT "bad access at address ");
+    sig_write_ptr(bad_addr);
+    sig_write_str("\n" SYS_REC_FMT "known valid address ranges:\n");
+    sig_write_range(
+      SYS_REC_FMT "  cell       stack:        ",
+      interp->cells.floor,
+      interp->cells.ceil
+    );
+    sig_write_range(
+      SYS_REC_FMT "  writable   instructions: ",
+      code->code_write.floor,
+      code->code_write.top
+    );
+    sig_write_range(
+      SYS_REC_FMT "  executable instructions: ",
+      code->code_exec.floor,
+      code->code_exec.top
+    );
+    sig_recovery_log_ctx(interp);
+    sig_exception_fallback(sig);
+    return;
+  }
+
+  sig_write_str(SYS_REC_FMT "detected ");
+  sig_write_str(msg);
+  sig_write_str("\n");
+  sig_recovery_log_ctx(interp);
+  sig_exception_fallback(sig);
+}
+
+static Err init_exception_handling() {
+  bool recovery = true;
+  try(env_bool("RECOVERY", &recovery));
+  if (!recovery) return nullptr;
+
+  // Signal handling is optional; failure to install is non-lethal.
+  const auto err = sig_exception_init(sig_on_bad_access);
+  if (err) {
+    eprintf("[system] %s\n", err);
+    return nullptr;
+  }
+
+  IF_DEBUG(eputs("[system] inited signal-based exception handling"));
+  return nullptr;
+}
@@ -55,7 +55,7 @@ static void sym_deinit(Sym *sym) {
 static void sym_init_intrin(Sym *sym) {
   sym->type        = SYM_INTRIN;
   sym->name.len    = (Ind)strlen(sym->name.buf);
-  sym->clobber     = ASM_REGS_VOLATILE;
+  sym->clobber     = SYM_CLOBBER_FOREIGN;
   sym->interp_only = true;
 }
 
@@ -117,30 +117,36 @@ static Err err_inline_has_data(const Sym *sym) {
   );
 }
 
-// SYNC[sym_inlinable].
+/*
+PC-relative instructions are validated by the assembler, which relocates them
+when inlining; see `asm_sym_inline_relocatable`.
+
+SYNC[sym_inlinable].
+*/
 static Err validate_sym_inlinable(const Sym *sym) {
   if (sym->type != SYM_NORM) return err_inline_not_norm(sym);
-  if (sym->norm.has_loads) return err_inline_pc_rel(sym);
   if (!is_sym_leaf(sym)) return err_inline_not_leaf(sym);
 
-  // Same as `err_inline_pc_rel`. Redundant check for safety.
   const auto spans = &sym->norm.spans;
-  IF_DEBUG(try_assert(sym->norm.has_loads == (spans->data < spans->ceil)));
   if (spans->data < spans->ceil) return err_inline_has_data(sym);
 
   return nullptr;
 }
 
-static void sym_auto_inlinable(Sym *sym) {
+/*
+The caller must also check `asm_sym_inline_relocatable`. `extra_len` is the
+length of instrumentation at the start of the body which doesn't count towards
+the limit, such as `--profile` counters.
+*/
+static void sym_auto_inlinable(Sym *sym, Ind extra_len) {
   // SYNC[sym_inlinable].
   if (sym->type != SYM_NORM) return;
-  if (sym->norm.has_loads) return;
   if (!is_sym_leaf(sym)) return;
 
   const auto spans = &sym->norm.spans;
   if (spans->data < spans->ceil) return;
 
-  const auto len = spans->epi_err - spans->inner;
+  const auto len = spans->epi_err - spans->inner - extra_len;
   if (len > ASM_INLINABLE_INSTR_LEN) return;
 
   sym->norm.inlinable = true;
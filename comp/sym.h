@@ -51,22 +51,35 @@ typedef struct Sym {
     struct {
       void       *exter;     // Address obtained from `dlsym`.
       const char *link_name; // Stable native symbol name.
+      U8          flt_inps;  // Bitmask of `F64` inputs; see `.extern_float`.
+      bool        flt_out;   // Output is `F64`; see `.extern_float`.
     };
   };
 
   Sym_set callees;     // Dependencies in compiled code.
   Sym_set callers;     // Dependents in compiled code.
   Bits    clobber;     // Clobbers these regs; also includes inps, outs, err.
+                       // Vector regs from `ASM_VEC_CLOBBER_SHIFT`.
   U8      inp_len;     // Input parameter count.
   U8      out_len;     // Output parameter count.
   bool    has_err;     // Last output is an error, or intrinsic returns `Err`.
   bool    comp_only;   // Can only be used between `:` and `;`.
   bool    interp_only; // Forbidden in AOT executables.
   bool    plain_call;  // Enables an ident-like callable name.
+  bool    pure;        // Calls with constant inputs are evaluated early.
+  Sym    *shadowed;    // Older entry in the wordlist; see `interp_dict_set`.
 } Sym;
 
 // Extern-only metadata must not bloat every symbol.
 static_assert(sizeof(Sym) <= 256);
 
+/*
+Intrinsics and externs are opaque to us, so we assume they clobber every
+volatile GPR and every vector register. The latter includes callee-saved
+ones, because C only preserves their low 64 bits.
+*/
+static constexpr Bits SYM_CLOBBER_FOREIGN =
+  ASM_REGS_VOLATILE | (ASM_VEC_REGS_ALL << ASM_VEC_CLOBBER_SHIFT);
+
 typedef stack_of(Sym)  Sym_stack;
 typedef dict_of(Sym *) Sym_dict;